@@ -0,0 +1,114 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "adjset.h"
+
+#define ADJSET_MIN_CAPACITY 4
+
+void adjset_init(struct adjset *set)
+{
+    set->items = NULL;
+    set->len = 0;
+    set->cap = 0;
+}
+
+void adjset_free(struct adjset *set)
+{
+    free(set->items);
+    adjset_init(set);
+}
+
+char adjset_copy(struct adjset *dst, const struct adjset *src)
+{
+    adjset_init(dst);
+    if (src->len == 0)
+        return 1;
+    dst->items = (int *)malloc(sizeof(int) * src->len);
+    if (!dst->items)
+        return 0;
+    memcpy(dst->items, src->items, sizeof(int) * src->len);
+    dst->len = dst->cap = src->len;
+    return 1;
+}
+
+/* return the position of the first entry that is not
+    smaller than <value> */
+static int adjset_lower_bound(const struct adjset *set, int value)
+{
+    int low = 0, high = set->len;
+    while (low < high)
+    {
+        int mid = low + (high - low) / 2;
+        if (set->items[mid] < value)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+char adjset_contains(const struct adjset *set, int value)
+{
+    int pos = adjset_lower_bound(set, value);
+    return pos < set->len && set->items[pos] == value;
+}
+
+/* make room for at least <needed> entries */
+static char adjset_reserve(struct adjset *set, int needed)
+{
+    if (needed <= set->cap)
+        return 1;
+    int newcap = set->cap ? set->cap : ADJSET_MIN_CAPACITY;
+    while (newcap < needed)
+        newcap *= 2;
+    int *items = (int *)realloc(set->items, sizeof(int) * newcap);
+    if (!items)
+        return 0;
+    set->items = items;
+    set->cap = newcap;
+    return 1;
+}
+
+int adjset_insert(struct adjset *set, int value)
+{
+    int pos = adjset_lower_bound(set, value);
+    if (pos < set->len && set->items[pos] == value)
+        return 0;
+    if (!adjset_reserve(set, set->len + 1))
+        return -1;
+    memmove(set->items + pos + 1, set->items + pos, sizeof(int) * (set->len - pos));
+    set->items[pos] = value;
+    set->len++;
+    return 1;
+}
+
+char adjset_merge(struct adjset *set, const int *values, int count,
+                  const char *drop)
+{
+    if (count == 0 && !drop)
+        return 1;
+    /* merge from the back so we can work in place */
+    int kept = set->len;
+    if (drop)
+    {
+        kept = 0;
+        for (int i = 0; i < set->len; i++)
+        {
+            if (!drop[set->items[i]])
+                set->items[kept++] = set->items[i];
+        }
+        set->len = kept;
+    }
+    if (!adjset_reserve(set, kept + count))
+        return 0;
+    int i = kept - 1, j = count - 1, k = kept + count - 1;
+    while (j >= 0)
+    {
+        if (i >= 0 && set->items[i] > values[j])
+            set->items[k--] = set->items[i--];
+        else
+            set->items[k--] = values[j--];
+    }
+    set->len = kept + count;
+    return 1;
+}
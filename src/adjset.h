@@ -0,0 +1,40 @@
+/* Growable sorted sets of vertex ids, used as neighbour
+    sets by the sparse graph representation.
+*/
+#ifndef ADJSET_H
+#define ADJSET_H
+
+struct adjset
+{
+    int *items; /* sorted ascending, no duplicates */
+    int len;    /* number of valid entries in <items> */
+    int cap;    /* allocated size of <items> */
+};
+
+/* initialise an empty set, no memory is allocated yet */
+void adjset_init(struct adjset *set);
+
+/* free the memory held by the set and reset it */
+void adjset_free(struct adjset *set);
+
+/* copy <src> into the (uninitialised) set <dst>
+    return 1 on success, 0 otherwise */
+char adjset_copy(struct adjset *dst, const struct adjset *src);
+
+/* return 1 if <value> is in the set, 0 otherwise */
+char adjset_contains(const struct adjset *set, int value);
+
+/* insert <value>, return 1 if it was not in the set before,
+    0 if it was and -1 if memory could not be allocated */
+int adjset_insert(struct adjset *set, int value);
+
+/* Union the set with the sorted, duplicate free list
+    <values> of length <count>, none of which may be in the
+    set already. Entries of the set for which
+    <drop> is set (if <drop> is not NULL) are removed on the
+    way, so stale entries do not accumulate.
+    return 1 on success, 0 otherwise */
+char adjset_merge(struct adjset *set, const int *values, int count,
+                  const char *drop);
+
+#endif
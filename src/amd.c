@@ -0,0 +1,436 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "amd.h"
+
+/* Negative indices mark absorbed vertices and elements:
+    offsets[v] = AMD_FLIP(p) means v was absorbed by p */
+#define AMD_FLIP(i) (-(i) - 2)
+
+#define AMD_MIN(a, b) ((a) < (b) ? (a) : (b))
+#define AMD_MAX(a, b) ((a) > (b) ? (a) : (b))
+
+size_t amd_capacity(int n, size_t entries)
+{
+    /* room for the new elements between garbage collections */
+    return entries + entries / 5 + 2 * (size_t)n + 1;
+}
+
+/* start a new mark in <w> (the marks are values >= <mark>),
+    clearing it if the marks would overflow */
+static int amd_clear(int mark, int lemax, int *w, int n)
+{
+    if (mark < 2 || mark + lemax < 0)
+    {
+        for (int k = 0; k < n; k++)
+        {
+            if (w[k] != 0)
+                w[k] = 1;
+        }
+        mark = 2;
+    }
+    return mark;
+}
+
+/* append the postorder of the tree below <j> to <post> from position <k>,
+    children are listed in <head> and <next>. return the next position */
+static int amd_postorder(int j, int k, int *head, const int *next, int *post, int *stack)
+{
+    int top = 0;
+    stack[0] = j;
+    while (top >= 0)
+    {
+        int p = stack[top];
+        int i = head[p];
+        if (i == -1)
+        {
+            top--;
+            post[k++] = p;
+        }
+        else
+        {
+            head[p] = next[i];
+            stack[++top] = i;
+        }
+    }
+    return k;
+}
+
+/*  The quotient graph lives in <adjacent>: the list of vertex i
+    starts at offsets[i] with its elen[i] adjacent elements followed
+    by its adjacent vertices, len[i] entries in total. The list of
+    an element holds its vertices. nv[i] is the number of vertices
+    the supervariable i stands for (0 if it was merged into another
+    one), degree[i] its approximate external degree. Vertices are
+    kept in lists by degree (head, next, last), elements are flagged
+    by elen[e] = -2. Vertex n collects the dense vertices, which are
+    left out and eliminated at the end.
+*/
+char amd_order(int n, int *offsets, int *adjacent, size_t capacity, int *ordering)
+{
+    int *work = (int *)malloc(sizeof(int) * 9 * ((size_t)n + 1));
+    if (!work)
+        return 0;
+    int *len = work, *nv = work + (n + 1), *next = work + 2 * (n + 1),
+        *head = work + 3 * (n + 1), *elen = work + 4 * (n + 1),
+        *degree = work + 5 * (n + 1), *w = work + 6 * (n + 1),
+        *hhead = work + 7 * (n + 1), *last = work + 8 * (n + 1);
+    int *cp = offsets, *ci = adjacent;
+    size_t nzmax = capacity;
+
+    /* vertices with more neighbours than this are dense */
+    int dense = AMD_MAX(16, (int)(10 * sqrt((double)n)));
+    dense = AMD_MIN(n - 2, dense);
+    int cnz = cp[n];
+    for (int k = 0; k < n; k++)
+        len[k] = cp[k + 1] - cp[k];
+    len[n] = 0;
+    for (int i = 0; i <= n; i++)
+    {
+        head[i] = -1;
+        last[i] = -1;
+        next[i] = -1;
+        hhead[i] = -1;
+        nv[i] = 1;
+        w[i] = 1;
+        elen[i] = 0;
+        degree[i] = len[i];
+    }
+    int mark = amd_clear(0, 0, w, n);
+    elen[n] = -2;
+    cp[n] = -1;
+    w[n] = 0;
+
+    /* degree lists, isolated vertices are eliminated right away */
+    int nel = 0;
+    for (int i = 0; i < n; i++)
+    {
+        int d = degree[i];
+        if (d == 0)
+        {
+            elen[i] = -2;
+            nel++;
+            cp[i] = -1;
+            w[i] = 0;
+        }
+        else if (d > dense)
+        {
+            nv[i] = 0;
+            elen[i] = -1;
+            nel++;
+            cp[i] = AMD_FLIP(n);
+            nv[n]++;
+        }
+        else
+        {
+            if (head[d] != -1)
+                last[head[d]] = i;
+            next[i] = head[d];
+            head[d] = i;
+        }
+    }
+
+    int mindeg = 0, lemax = 0;
+    while (nel < n)
+    {
+        /* the pivot k has the smallest approximate degree */
+        int k = -1;
+        for (; mindeg < n && (k = head[mindeg]) == -1; mindeg++)
+            ;
+        if (next[k] != -1)
+            last[next[k]] = -1;
+        head[mindeg] = next[k];
+        int elenk = elen[k];
+        int nvk = nv[k];
+        nel += nvk;
+
+        /* compact the lists if the new element may not fit */
+        if (elenk > 0 && (size_t)cnz + mindeg >= nzmax)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                int p = cp[j];
+                if (p >= 0)
+                {
+                    cp[j] = ci[p];
+                    ci[p] = AMD_FLIP(j);
+                }
+            }
+            int q = 0;
+            for (int p = 0; p < cnz;)
+            {
+                int j = AMD_FLIP(ci[p++]);
+                if (j >= 0)
+                {
+                    ci[q] = cp[j];
+                    cp[j] = q++;
+                    for (int k3 = 0; k3 < len[j] - 1; k3++)
+                        ci[q++] = ci[p++];
+                }
+            }
+            cnz = q;
+        }
+
+        /* the new element k is the union of the vertices of k
+            and of the elements adjacent to k */
+        int dk = 0;
+        nv[k] = -nvk;
+        int p = cp[k];
+        int pk1 = elenk == 0 ? p : cnz;
+        int pk2 = pk1;
+        for (int k1 = 1; k1 <= elenk + 1; k1++)
+        {
+            int e, pj, ln;
+            if (k1 > elenk)
+            {
+                e = k;
+                pj = p;
+                ln = len[k] - elenk;
+            }
+            else
+            {
+                e = ci[p++];
+                pj = cp[e];
+                ln = len[e];
+            }
+            for (int k2 = 1; k2 <= ln; k2++)
+            {
+                int i = ci[pj++];
+                int nvi = nv[i];
+                if (nvi <= 0)
+                    continue;
+                dk += nvi;
+                nv[i] = -nvi; /* marks i as member of k */
+                ci[pk2++] = i;
+                if (next[i] != -1)
+                    last[next[i]] = last[i];
+                if (last[i] != -1)
+                    next[last[i]] = next[i];
+                else
+                    head[degree[i]] = next[i];
+            }
+            if (e != k)
+            {
+                /* absorb e into k */
+                cp[e] = AMD_FLIP(k);
+                w[e] = 0;
+            }
+        }
+        if (elenk != 0)
+            cnz = pk2;
+        degree[k] = dk;
+        cp[k] = pk1;
+        len[k] = pk2 - pk1;
+        elen[k] = -2;
+
+        /* w[e] - mark becomes the size of element e outside of k */
+        mark = amd_clear(mark, lemax, w, n);
+        for (int pk = pk1; pk < pk2; pk++)
+        {
+            int i = ci[pk];
+            int eln = elen[i];
+            if (eln <= 0)
+                continue;
+            int nvi = -nv[i];
+            int wnvi = mark - nvi;
+            for (p = cp[i]; p <= cp[i] + eln - 1; p++)
+            {
+                int e = ci[p];
+                if (w[e] >= mark)
+                    w[e] -= nvi;
+                else if (w[e] != 0)
+                    w[e] = degree[e] + wnvi;
+            }
+        }
+
+        /* approximate degrees of the vertices of k */
+        for (int pk = pk1; pk < pk2; pk++)
+        {
+            int i = ci[pk];
+            int p1 = cp[i];
+            int p2 = p1 + elen[i] - 1;
+            int pn = p1;
+            unsigned long h = 0;
+            int d = 0;
+            for (p = p1; p <= p2; p++)
+            {
+                int e = ci[p];
+                if (w[e] != 0)
+                {
+                    int dext = w[e] - mark;
+                    if (dext > 0)
+                    {
+                        d += dext;
+                        ci[pn++] = e;
+                        h += e;
+                    }
+                    else
+                    {
+                        /* e is a subset of k, absorb it */
+                        cp[e] = AMD_FLIP(k);
+                        w[e] = 0;
+                    }
+                }
+            }
+            elen[i] = pn - p1 + 1;
+            int p3 = pn;
+            int p4 = p1 + len[i];
+            for (p = p2 + 1; p < p4; p++)
+            {
+                int j = ci[p];
+                int nvj = nv[j];
+                if (nvj <= 0)
+                    continue;
+                d += nvj;
+                ci[pn++] = j;
+                h += j;
+            }
+            if (d == 0)
+            {
+                /* i has no neighbours outside of k,
+                    eliminate it together with k */
+                cp[i] = AMD_FLIP(k);
+                int nvi = -nv[i];
+                dk -= nvi;
+                nvk += nvi;
+                nel += nvi;
+                nv[i] = 0;
+                elen[i] = -1;
+            }
+            else
+            {
+                degree[i] = AMD_MIN(degree[i], d);
+                /* k becomes the first element of i */
+                ci[pn] = ci[p3];
+                ci[p3] = ci[p1];
+                ci[p1] = k;
+                len[i] = pn - p1 + 1;
+                /* hash the neighbourhood to find equal ones */
+                h %= (unsigned long)n;
+                next[i] = hhead[h];
+                hhead[h] = i;
+                last[i] = (int)h;
+            }
+        }
+        degree[k] = dk;
+        lemax = AMD_MAX(lemax, dk);
+        mark = amd_clear(mark + lemax, lemax, w, n);
+
+        /* merge vertices with the same neighbourhood (in a hash bucket) */
+        for (int pk = pk1; pk < pk2; pk++)
+        {
+            int i = ci[pk];
+            if (nv[i] >= 0)
+                continue;
+            int h = last[i];
+            i = hhead[h];
+            hhead[h] = -1;
+            for (; i != -1 && next[i] != -1; i = next[i], mark++)
+            {
+                int ln = len[i];
+                int eln = elen[i];
+                for (p = cp[i] + 1; p <= cp[i] + ln - 1; p++)
+                    w[ci[p]] = mark;
+                int jlast = i;
+                for (int j = next[i]; j != -1;)
+                {
+                    int ok = len[j] == ln && elen[j] == eln;
+                    for (p = cp[j] + 1; ok && p <= cp[j] + ln - 1; p++)
+                    {
+                        if (w[ci[p]] != mark)
+                            ok = 0;
+                    }
+                    if (ok)
+                    {
+                        /* j is indistinguishable from i, absorb it */
+                        cp[j] = AMD_FLIP(i);
+                        nv[i] += nv[j];
+                        nv[j] = 0;
+                        elen[j] = -1;
+                        j = next[j];
+                        next[jlast] = j;
+                    }
+                    else
+                    {
+                        jlast = j;
+                        j = next[j];
+                    }
+                }
+            }
+        }
+
+        /* put the remaining vertices of k back into the degree lists */
+        p = pk1;
+        for (int pk = pk1; pk < pk2; pk++)
+        {
+            int i = ci[pk];
+            int nvi = -nv[i];
+            if (nvi <= 0)
+                continue;
+            nv[i] = nvi;
+            int d = degree[i] + dk - nvi;
+            d = AMD_MIN(d, n - nel - nvi);
+            if (head[d] != -1)
+                last[head[d]] = i;
+            next[i] = head[d];
+            last[i] = -1;
+            head[d] = i;
+            mindeg = AMD_MIN(mindeg, d);
+            degree[i] = d;
+            ci[p++] = i;
+        }
+        nv[k] = nvk;
+        len[k] = p - pk1;
+        if (len[k] == 0)
+        {
+            /* k has no neighbours left, it is a root */
+            cp[k] = -1;
+            w[k] = 0;
+        }
+        if (elenk != 0)
+            cnz = p;
+    }
+
+    /* The elimination follows the tree of absorptions: every
+        vertex comes before the one that absorbed it, so a postorder
+        of that tree is the ordering. Merged vertices are listed
+        below their representative and eliminated right before it. */
+    for (int i = 0; i < n; i++)
+        cp[i] = AMD_FLIP(cp[i]);
+    for (int j = 0; j <= n; j++)
+        head[j] = -1;
+    for (int j = n; j >= 0; j--)
+    {
+        /* merged vertices first */
+        if (nv[j] > 0)
+            continue;
+        next[j] = head[cp[j]];
+        head[cp[j]] = j;
+    }
+    for (int e = n; e >= 0; e--)
+    {
+        /* then the elements */
+        if (nv[e] <= 0)
+            continue;
+        if (cp[e] != -1)
+        {
+            next[e] = head[cp[e]];
+            head[cp[e]] = e;
+        }
+    }
+    int *post = hhead; /* n + 1 entries including vertex n */
+    int k = 0;
+    for (int i = 0; i <= n; i++)
+    {
+        if (cp[i] == -1)
+            k = amd_postorder(i, k, head, next, post, w);
+    }
+    /* leave out the collector of the dense vertices */
+    for (int i = 0, j = 0; i < k; i++)
+    {
+        if (post[i] != n)
+            ordering[j++] = post[i];
+    }
+    free(work);
+    return 1;
+}
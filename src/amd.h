@@ -0,0 +1,30 @@
+/* Approximate minimum degree ordering (Amestoy, Davis and Duff).
+    Instead of adding the fill-in edges of an elimination, the
+    eliminated vertices are kept as "elements" that stand for the
+    clique of their neighbours (quotient graph), so the memory stays
+    in O(n + m). Elements adjacent to a new element are absorbed by
+    it, vertices with the same neighbourhood are merged into one
+    supervariable and eliminated together, and the degrees are upper
+    bounds (external degrees) that are cheap to update instead of the
+    exact degrees of the min-degree heuristic.
+*/
+#ifndef AMD_H
+#define AMD_H
+
+#include <stddef.h>
+
+/* Order the <n> vertices of the graph whose neighbours of vertex v
+    are adjacent[offsets[v]] to adjacent[offsets[v + 1] - 1], without
+    self loops and with every edge in both directions.
+    <adjacent> is used as workspace: it has to hold <capacity> ints,
+    at least amd_capacity(n, offsets[n]), and is overwritten.
+    <offsets> needs n + 1 entries and is overwritten as well.
+    The vertex eliminated i-th is written to ordering[i].
+    return 1 on success, 0 if there is not enough memory */
+char amd_order(int n, int *offsets, int *adjacent, size_t capacity, int *ordering);
+
+/* size of the workspace amd_order needs for <n> vertices
+    and <entries> neighbour entries */
+size_t amd_capacity(int n, size_t entries);
+
+#endif
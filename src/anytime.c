@@ -0,0 +1,376 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "anytime.h"
+#include "timing.h"
+
+/* local search moves per round at least, even if the runs are fast */
+#define ANYTIME_MIN_MOVES 16
+
+/* vertices are moved by up to n / ANYTIME_WINDOW positions */
+#define ANYTIME_WINDOW 16
+
+struct anytime
+{
+    Graph g;
+    int n;
+    double start;
+    double deadline;
+    int lower_bound;       /* the search ends at this width */
+    const struct reduction *reduction; /* NULL if g is not a kernel */
+    int floor;             /* width of the eliminated prefix, 0 without reduction */
+    int *expanded;         /* ordering of the reduced graph */
+    FILE *stream;
+    const char *path;
+    FILE *log;
+    struct anytime_result *result;
+    int *best;             /* best ordering so far */
+    int *buffer;           /* ordering of the last run */
+    int *current;          /* ordering of the local search */
+    int *columns;          /* bag sizes of <current>, see graph_ordering_columns */
+    int *candidate;        /* bag sizes after a move */
+    int current_width;     /* -1 to start again from the best ordering */
+    int current_widest;    /* number of bags of that size */
+    long long current_squares; /* sum of the squared bag sizes */
+    uint64_t random_state; /* of the local search */
+    atomic_int bound;      /* best width - 1, -1 once the time is up */
+    atomic_int stop;
+    pthread_mutex_t lock;  /* wakes the timer when the search ends early */
+    pthread_cond_t finished_cond;
+    char finished;
+};
+
+/* stop the search: the running heuristic stops at its next
+    elimination since every width exceeds the bound */
+static void anytime_stop(struct anytime *a)
+{
+    atomic_store(&a->stop, 1);
+    atomic_store(&a->bound, -1);
+}
+
+/* wait until the deadline or the end of the search */
+static void *anytime_timer(void *arg)
+{
+    struct anytime *a = (struct anytime *)arg;
+    struct timespec until;
+    clock_gettime(CLOCK_REALTIME, &until);
+    double remaining = a->deadline - timing_now();
+    if (remaining < 0)
+        remaining = 0;
+    long long nanoseconds = until.tv_nsec + (long long)((remaining - (long long)remaining) * 1e9);
+    until.tv_sec += (time_t)remaining + nanoseconds / 1000000000;
+    until.tv_nsec = nanoseconds % 1000000000;
+
+    pthread_mutex_lock(&a->lock);
+    int rc = 0;
+    while (!a->finished && rc != ETIMEDOUT)
+        rc = pthread_cond_timedwait(&a->finished_cond, &a->lock, &until);
+    pthread_mutex_unlock(&a->lock);
+    anytime_stop(a);
+    return NULL;
+}
+
+/* xorshift64* for the local search */
+static uint64_t anytime_random(struct anytime *a)
+{
+    a->random_state ^= a->random_state >> 12;
+    a->random_state ^= a->random_state << 25;
+    a->random_state ^= a->random_state >> 27;
+    return a->random_state * 0x2545F4914F6CDD1DULL;
+}
+
+static void anytime_write_ordering(FILE *stream, const int *ordering, int n)
+{
+    for (int i = 0; i < n; i++)
+        fprintf(stream, i > 0 ? " %d" : "%d", ordering[i]);
+    fprintf(stream, "\n");
+}
+
+/* replace the file <path> by <ordering> in one step */
+static void anytime_write_file(const char *path, const int *ordering, int n)
+{
+    size_t len = strlen(path);
+    char *temporary = (char *)malloc(len + 5);
+    if (!temporary)
+        return;
+    memcpy(temporary, path, len);
+    memcpy(temporary + len, ".tmp", 5);
+    FILE *file = fopen(temporary, "w");
+    if (file)
+    {
+        anytime_write_ordering(file, ordering, n);
+        if (fclose(file) == 0 && rename(temporary, path) == 0)
+        {
+            free(temporary);
+            return;
+        }
+    }
+    fprintf(stderr, "Error writing the ordering to %s\n", path);
+    remove(temporary);
+    free(temporary);
+}
+
+/* width of the whole graph for the width <width> of g */
+static int anytime_floor(struct anytime *a, int width)
+{
+    return width > a->floor ? width : a->floor;
+}
+
+/* take <ordering> of <width> (see anytime_floor) as the new best one */
+static void anytime_improved(struct anytime *a, const int *ordering, int width, const char *phase)
+{
+    struct anytime_result *r = a->result;
+    if (ordering != a->best)
+        memcpy(a->best, ordering, sizeof(int) * a->n);
+    r->best_width = width;
+    r->best_time = timing_now() - a->start;
+    r->phase = phase;
+    r->improvements++;
+    int bound = atomic_load(&a->bound);
+    while (width - 1 < bound && !atomic_compare_exchange_weak(&a->bound, &bound, width - 1))
+        ;
+
+    const int *written = a->best;
+    int n = a->n;
+    if (a->reduction)
+    {
+        reduction_expand(a->reduction, a->best, a->expanded);
+        written = a->expanded;
+        n = a->reduction->n;
+    }
+    if (a->stream)
+    {
+        anytime_write_ordering(a->stream, written, n);
+        fflush(a->stream);
+    }
+    if (a->path)
+        anytime_write_file(a->path, written, n);
+    if (a->log)
+    {
+        fprintf(a->log, "Width %d after %f s (%s)\n", width, r->best_time, phase);
+        fflush(a->log);
+    }
+    /* the prefix width is at most the treewidth, see reduce.h */
+    if (width <= a->lower_bound || (a->reduction && width <= a->floor))
+        anytime_stop(a);
+}
+
+/* order a clone of g with <heuristic>, with random ties for
+    <seed> != 0 and stopped by the bound if <bounded>.
+    return the width, or a negative value as graph_order */
+static int anytime_run(struct anytime *a, strategy heuristic, uint64_t seed,
+                       char bounded, const char *phase)
+{
+    Graph clone = graph_clone(a->g);
+    if (!clone)
+        return -1;
+    if (seed != 0)
+        graph_set_random_ties(clone, seed);
+    if (bounded)
+        graph_set_width_bound(clone, &a->bound);
+    int width = graph_order(clone, heuristic, mcs_tie_min);
+    if (width >= 0 && (a->result->improvements == 0 || anytime_floor(a, width) < a->result->best_width))
+    {
+        graph_get_ordering(clone, a->buffer);
+        anytime_improved(a, a->buffer, anytime_floor(a, width), phase);
+        a->current_width = -1;
+    }
+    graph_destroy(clone);
+    return width;
+}
+
+/* width of <ordering>, the number of bags of that size and
+    the sum of the squared bag sizes */
+static int anytime_evaluate(struct anytime *a, const int *ordering, int *columns,
+                            int *widest, long long *squares)
+{
+    graph_set_ordering(a->g, ordering);
+    int width = graph_ordering_columns(a->g, columns);
+    *widest = 0;
+    *squares = 0;
+    for (int k = 0; k < a->n; k++)
+    {
+        if (columns[k] == width)
+            (*widest)++;
+        *squares += (long long)(columns[k] + 1) * (columns[k] + 1);
+    }
+    return width;
+}
+
+/* move the vertex at position <from> to position <to>,
+    shifting the vertices in between */
+static void anytime_move(int *ordering, int from, int to)
+{
+    int vertex = ordering[from];
+    if (from < to)
+        memmove(ordering + from, ordering + from + 1, sizeof(int) * (to - from));
+    else
+        memmove(ordering + to + 1, ordering + to, sizeof(int) * (from - to));
+    ordering[to] = vertex;
+}
+
+/*  Local search until <until>: a vertex whose bag has the size
+    of the width is moved to a random position nearby, and the move
+    is kept if neither the width nor the number of bags of that size
+    grow. Moves that keep both let the search cross plateaus, so the
+    ordering is kept for the next call unless a run found a better
+    one meanwhile. */
+static void anytime_local_search(struct anytime *a, double until)
+{
+    int n = a->n;
+    if (n < 2)
+        return;
+    int *current = a->current;
+    if (a->current_width < 0)
+    {
+        memcpy(current, a->best, sizeof(int) * n);
+        a->current_width = anytime_evaluate(a, current, a->columns,
+                                            &a->current_widest, &a->current_squares);
+    }
+    int width = a->current_width;
+    int window = n / ANYTIME_WINDOW > 0 ? n / ANYTIME_WINDOW : 1;
+
+    for (int moves = 0; width >= 0 && !atomic_load(&a->stop); moves++)
+    {
+        double now = timing_now();
+        if (now >= a->deadline || (moves >= ANYTIME_MIN_MOVES && now >= until))
+            break;
+        a->result->moves++;
+        /* one of the widest bags at random */
+        int from = -1, seen = 0;
+        for (int k = 0; k < n; k++)
+        {
+            if (a->columns[k] == width && anytime_random(a) % ++seen == 0)
+                from = k;
+        }
+        int distance = 1 + (int)(anytime_random(a) % (uint64_t)window);
+        int to = anytime_random(a) % 2 ? from + distance : from - distance;
+        if (to < 0)
+            to = 0;
+        if (to >= n)
+            to = n - 1;
+        if (to == from)
+            continue;
+        anytime_move(current, from, to);
+        int widest;
+        long long squares;
+        int candidate_width = anytime_evaluate(a, current, a->candidate, &widest, &squares);
+        if (candidate_width < 0 || candidate_width > width ||
+            (candidate_width == width && widest > a->current_widest) ||
+            (candidate_width == width && widest == a->current_widest && squares > a->current_squares))
+        {
+            anytime_move(current, to, from);
+            continue;
+        }
+        int *swap = a->columns;
+        a->columns = a->candidate;
+        a->candidate = swap;
+        width = a->current_width = candidate_width;
+        a->current_widest = widest;
+        a->current_squares = squares;
+        if (anytime_floor(a, width) < a->result->best_width)
+            anytime_improved(a, current, anytime_floor(a, width), "Local search");
+    }
+}
+
+static void anytime_free(struct anytime *a)
+{
+    free(a->best);
+    free(a->buffer);
+    free(a->current);
+    free(a->columns);
+    free(a->candidate);
+    free(a->expanded);
+}
+
+char anytime_order(Graph g, double limit, uint64_t seed, int lower_bound,
+                   const struct reduction *reduction, FILE *stream,
+                   const char *path, FILE *log, struct anytime_result *result)
+{
+    struct anytime a;
+    a.g = g;
+    a.n = graph_vertex_count(g);
+    a.start = timing_now();
+    a.deadline = a.start + limit;
+    a.lower_bound = lower_bound;
+    a.reduction = reduction;
+    a.floor = reduction ? reduction->width : 0;
+    a.expanded = reduction ? (int *)malloc(sizeof(int) * (reduction->n + 1)) : NULL;
+    a.stream = stream;
+    a.path = path;
+    a.log = log;
+    a.result = result;
+    a.best = (int *)malloc(sizeof(int) * (a.n > 0 ? a.n : 1));
+    a.buffer = (int *)malloc(sizeof(int) * (a.n > 0 ? a.n : 1));
+    a.current = (int *)malloc(sizeof(int) * (a.n > 0 ? a.n : 1));
+    a.columns = (int *)malloc(sizeof(int) * (a.n > 0 ? a.n : 1));
+    a.candidate = (int *)malloc(sizeof(int) * (a.n > 0 ? a.n : 1));
+    a.current_width = -1;
+    a.random_state = seed * 0x9E3779B97F4A7C15ULL + 1;
+    if (a.random_state == 0)
+        a.random_state = 1;
+    atomic_init(&a.bound, INT_MAX);
+    atomic_init(&a.stop, 0);
+    a.finished = 0;
+    result->best_width = -1;
+    result->best_time = 0;
+    result->phase = NULL;
+    result->improvements = 0;
+    result->restarts = 0;
+    result->moves = 0;
+    if (!a.best || !a.buffer || !a.current || !a.columns || !a.candidate ||
+        (reduction && !a.expanded))
+    {
+        anytime_free(&a);
+        return 0;
+    }
+    pthread_mutex_init(&a.lock, NULL);
+    pthread_cond_init(&a.finished_cond, NULL);
+    pthread_t timer;
+    if (pthread_create(&timer, NULL, anytime_timer, &a) != 0)
+    {
+        /* without a timer the phases check the time in between */
+        pthread_cond_destroy(&a.finished_cond);
+        pthread_mutex_destroy(&a.lock);
+        a.finished = 1;
+    }
+
+    /* a first ordering, without a time limit */
+    anytime_run(&a, degree, 0, 0, "Min-Degree");
+    if (result->improvements > 0)
+    {
+        if (!atomic_load(&a.stop) && timing_now() < a.deadline)
+            anytime_run(&a, fillin, 0, 1, "Min-Fill-in");
+        for (uint64_t i = 1; !atomic_load(&a.stop) && timing_now() < a.deadline; i++)
+        {
+            double round = timing_now();
+            result->restarts++;
+            anytime_run(&a, i % 2 ? degree : fillin, seed + i, 1,
+                        i % 2 ? "Min-Degree restart" : "Min-Fill-in restart");
+            /* as much time for the local search as for the run */
+            double now = timing_now();
+            anytime_local_search(&a, now + (now - round));
+        }
+    }
+
+    if (!a.finished)
+    {
+        pthread_mutex_lock(&a.lock);
+        a.finished = 1;
+        pthread_cond_signal(&a.finished_cond);
+        pthread_mutex_unlock(&a.lock);
+        pthread_join(timer, NULL);
+        pthread_cond_destroy(&a.finished_cond);
+        pthread_mutex_destroy(&a.lock);
+    }
+    if (result->improvements > 0)
+        graph_set_ordering(g, a.best);
+    anytime_free(&a);
+    return result->improvements > 0;
+}
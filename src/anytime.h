@@ -0,0 +1,51 @@
+/* Anytime orderings: an ordering is available almost right away
+    and improved until a time limit is reached. The first ordering
+    is the one of Min-Degree, followed by Min-Fill-in and then, until
+    the time is up, by Min-Degree and Min-Fill-in runs with random
+    tie breaking (see graph_set_random_ties) that alternate with a
+    local search on the best ordering. Every run is stopped as soon
+    as it can not beat the best width any more, and once the time is
+    up. Each improvement is written out right away, so a caller can
+    stop the process at any time and use the last ordering written.
+    Given a lower bound, the search ends as soon as it is reached.
+    After a reduction (see reduce.h) only the kernel is searched,
+    while the orderings written out are those of the whole graph.
+*/
+#ifndef ANYTIME_H
+#define ANYTIME_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "graph.h"
+#include "reduce.h"
+
+struct anytime_result
+{
+    int best_width;
+    double best_time;   /* seconds from the start to the best ordering */
+    const char *phase;  /* the phase that found it */
+    int improvements;
+    int restarts;       /* randomized runs started */
+    long moves;         /* local search moves tried */
+};
+
+/* Order g for <limit> seconds (the Min-Degree ordering is always
+    completed, even if that takes longer). The random runs use the
+    seeds <seed> + 1, <seed> + 2 and so on. Each improvement is
+    printed as a line of the ordering to <stream>, replaces the
+    contents of the file <path> (through a temporary file, so the
+    file always holds a complete ordering) and its width is reported
+    on <log>; each of them may be NULL. The search stops early once
+    the width equals <lower_bound> (-1 if unknown).
+    If <reduction> is not NULL, g is its kernel: the orderings
+    written out are expanded to the reduced graph and the widths
+    include the one of the eliminated prefix.
+    g itself has to be unchanged (not ordered before), afterwards
+    it holds the best ordering without the eliminated graph.
+    return 1 on success, 0 if not even Min-Degree succeeded */
+char anytime_order(Graph g, double limit, uint64_t seed, int lower_bound,
+                   const struct reduction *reduction, FILE *stream,
+                   const char *path, FILE *log, struct anytime_result *result);
+
+#endif
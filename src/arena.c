@@ -0,0 +1,109 @@
+#include <stdlib.h>
+
+#include "arena.h"
+
+#define ARENA_ALIGNMENT 64
+
+struct arena_block
+{
+    struct arena_block *next;
+    size_t size; /* usable bytes after the header */
+    size_t used;
+};
+
+/* the data of a block starts after the header, rounded
+    up to keep it aligned */
+#define ARENA_HEADER \
+    ((sizeof(struct arena_block) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT)
+
+static size_t round_up(size_t bytes)
+{
+    return (bytes + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+}
+
+void arena_init(struct arena *a, size_t min_block)
+{
+    a->first = NULL;
+    a->current = NULL;
+    a->min_block = round_up(min_block ? min_block : ARENA_ALIGNMENT);
+}
+
+void arena_free(struct arena *a)
+{
+    struct arena_block *block = a->first;
+    while (block)
+    {
+        struct arena_block *next = block->next;
+        free(block);
+        block = next;
+    }
+    a->first = NULL;
+    a->current = NULL;
+}
+
+void *arena_alloc(struct arena *a, size_t bytes)
+{
+    bytes = round_up(bytes ? bytes : 1);
+
+    /* Blocks after the current one are unused, move on
+        until one of them is large enough */
+    struct arena_block *block = a->current;
+    if (!block && a->first)
+    {
+        block = a->first;
+        block->used = 0;
+    }
+    struct arena_block *last = block;
+    while (block && block->used + bytes > block->size)
+    {
+        last = block;
+        block = block->next;
+        if (block)
+            block->used = 0;
+    }
+
+    if (!block)
+    {
+        /* grow geometrically, so the number of blocks stays small */
+        size_t size = a->min_block;
+        if (last && last->size * 2 > size)
+            size = last->size * 2;
+        if (bytes > size)
+            size = bytes;
+        block = (struct arena_block *)aligned_alloc(ARENA_ALIGNMENT, ARENA_HEADER + size);
+        if (!block)
+            return NULL;
+        block->next = NULL;
+        block->size = size;
+        block->used = 0;
+        /* append to the end of the list */
+        if (!a->first)
+            a->first = block;
+        else
+        {
+            while (last->next)
+                last = last->next;
+            last->next = block;
+        }
+    }
+
+    a->current = block;
+    void *result = (char *)block + ARENA_HEADER + block->used;
+    block->used += bytes;
+    return result;
+}
+
+struct arena_mark arena_get_mark(struct arena *a)
+{
+    struct arena_mark mark;
+    mark.block = a->current;
+    mark.used = a->current ? a->current->used : 0;
+    return mark;
+}
+
+void arena_reset(struct arena *a, struct arena_mark mark)
+{
+    a->current = mark.block;
+    if (mark.block)
+        mark.block->used = mark.used;
+}
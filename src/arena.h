@@ -0,0 +1,47 @@
+/* Region allocator for scratch buffers.
+    Memory is taken from large blocks and given back in one
+    go by resetting the arena to a mark taken earlier. The
+    blocks are kept for reuse, so once the arena has grown to
+    the size a computation needs, it does not allocate anymore.
+*/
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+struct arena_block;
+
+struct arena
+{
+    struct arena_block *first;   /* list of all blocks */
+    struct arena_block *current; /* block allocations are taken from */
+    size_t min_block;            /* size of the first block */
+};
+
+/* position in an arena to go back to with arena_reset */
+struct arena_mark
+{
+    struct arena_block *block;
+    size_t used;
+};
+
+/* initialise an empty arena, no memory is allocated until
+    the first call to arena_alloc. The first block will have
+    at least <min_block> bytes. */
+void arena_init(struct arena *a, size_t min_block);
+
+/* free all blocks of the arena */
+void arena_free(struct arena *a);
+
+/* return <bytes> bytes aligned to a cache line or NULL
+    if no memory could be allocated. The memory is not
+    initialised. */
+void *arena_alloc(struct arena *a, size_t bytes);
+
+/* remember the current position in the arena */
+struct arena_mark arena_get_mark(struct arena *a);
+
+/* release everything allocated after <mark> was taken */
+void arena_reset(struct arena *a, struct arena_mark mark);
+
+#endif
@@ -0,0 +1,704 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+
+#include "benchmark.h"
+#include "timing.h"
+#include "reduce.h"
+
+/* number of heuristics run on every graph in benchmark mode */
+#define BENCHMARK_HEURISTICS 4
+
+/* jobs per graph: the heuristics and the lower bound */
+#define BENCHMARK_JOBS (BENCHMARK_HEURISTICS + 1)
+
+/* names of the heuristics in the result columns */
+const char *BENCHMARK_NAMES[BENCHMARK_HEURISTICS] = {"Min-Degree", "Min-Fill-in", "MCS", "AMD"};
+
+/* maximum number of columns read from a baseline file */
+#define BASELINE_MAX_COLUMNS 256
+
+/* Write the header of results.csv. The first columns are the width
+    and (median) time of each heuristic and the treewidth lower bound
+    (see graph_lower_bound) with its time, followed by the import time,
+    the size of the kernel and the time of the reductions (empty
+    without reductions),
+    the phases of each heuristic, the spread of the times and
+    the hardware counters. */
+void print_file_header(FILE *fptr)
+{
+  fprintf(fptr, "Filename");
+  for (int h = 0; h < BENCHMARK_HEURISTICS; h++)
+    fprintf(fptr, ",Width %s,Time %s", BENCHMARK_NAMES[h], BENCHMARK_NAMES[h]);
+  fprintf(fptr, ",Lower Bound,Time Lower Bound");
+  fprintf(fptr, ",Time Import,Kernel Vertices,Time Reduction");
+  for (int h = 0; h < BENCHMARK_HEURISTICS; h++)
+    fprintf(fptr, ",Time Initial %s,Time Ordering %s,Time Width %s",
+            BENCHMARK_NAMES[h], BENCHMARK_NAMES[h], BENCHMARK_NAMES[h]);
+  fprintf(fptr, ",Repeats");
+  for (int h = 0; h < BENCHMARK_HEURISTICS; h++)
+    fprintf(fptr, ",Time Min %s,Time P95 %s,Time Stddev %s",
+            BENCHMARK_NAMES[h], BENCHMARK_NAMES[h], BENCHMARK_NAMES[h]);
+  for (int h = 0; h < BENCHMARK_HEURISTICS; h++)
+    for (int c = 0; c < PERF_COUNTERS; c++)
+      fprintf(fptr, ",%s %s", PERF_COUNTER_NAMES[c], BENCHMARK_NAMES[h]);
+  fprintf(fptr, "\n");
+}
+
+char file_header_matches(FILE *fptr)
+{
+  char *expected = NULL, *line = NULL;
+  size_t expected_len = 0, line_len = 0;
+  FILE *buffer = open_memstream(&expected, &expected_len);
+  if (buffer == NULL)
+    return 0;
+  print_file_header(buffer);
+  fclose(buffer);
+  char matches = getline(&line, &line_len, fptr) >= 0 && strcmp(line, expected) == 0;
+  free(line);
+  free(expected);
+  return matches;
+}
+
+/* A graph of the benchmark list and its results */
+struct bench_file
+{
+  char name[FILENAME_MAX_LENGTH];
+  off_t size;            /* file size, larger graphs are scheduled first */
+  pthread_mutex_t lock;  /* protects everything below */
+  Graph g;               /* imported graph (the kernel with reductions),
+                            copied by each heuristic job */
+  char imported;         /* 1 if the import was done (or failed) */
+  char failed;
+  int remaining;         /* jobs not yet finished */
+  double import_time;
+  int kernel_n;          /* -1 without reductions */
+  int prefix_width;      /* width of the eliminated vertices */
+  int reduction_low;     /* lower bound found by the reductions */
+  double reduction_time;
+  int width[BENCHMARK_HEURISTICS];
+  int lower_bound;
+  double lower_bound_time;
+  /* statistics of the measured runs */
+  double time[BENCHMARK_HEURISTICS]; /* median */
+  double time_min[BENCHMARK_HEURISTICS];
+  double time_p95[BENCHMARK_HEURISTICS];
+  double time_stddev[BENCHMARK_HEURISTICS];
+  /* phases and counters of the run with the median time */
+  struct ordering_times phases[BENCHMARK_HEURISTICS];
+  long long counters[BENCHMARK_HEURISTICS][PERF_COUNTERS]; /* -1 if not measured */
+};
+
+/* a single run of a heuristic */
+struct bench_run
+{
+  double time;
+  struct ordering_times phases;
+  long long counters[PERF_COUNTERS];
+};
+
+/* The jobs of a benchmark: job j runs heuristic j % BENCHMARK_JOBS
+    on files[j / BENCHMARK_JOBS], or computes the lower bound of that
+    file if j % BENCHMARK_JOBS is BENCHMARK_HEURISTICS.
+    Workers take the next job from a shared counter. */
+struct bench_queue
+{
+  struct bench_file *files;
+  int count;
+  const struct benchmark_options *options;
+  int *cpus;     /* cpus the process may run on, for pinning */
+  int cpu_count;
+  atomic_int next_job;
+  atomic_int failed;
+};
+
+/* argument of a worker thread */
+struct bench_worker
+{
+  struct bench_queue *queue;
+  int index;
+  pthread_t thread;
+};
+
+/* import the graph of <file> if no other job did yet,
+    return NULL if it could not be imported */
+Graph benchmark_import(struct bench_file *file, const struct benchmark_options *options)
+{
+  pthread_mutex_lock(&file->lock);
+  if (!file->imported)
+  {
+    file->imported = 1;
+    double start = timing_now();
+    file->g = graph_import_path(file->name, options->rep, options->cache);
+    file->import_time = timing_now() - start;
+    if (file->g == NULL)
+      file->failed = 1;
+    else if (options->reduce)
+    {
+      /* the jobs order the kernel instead of the graph */
+      struct reduction reduction;
+      start = timing_now();
+      if (reduction_run(file->g, graph_lower_bound(file->g, lb_min_d), &reduction))
+      {
+        file->reduction_time = timing_now() - start;
+        file->kernel_n = reduction.kernel_n;
+        file->prefix_width = reduction.width;
+        file->reduction_low = reduction.low;
+        graph_destroy(file->g);
+        file->g = reduction.kernel;
+        reduction.kernel = NULL;
+        reduction_free(&reduction);
+      }
+      else
+        file->failed = 1;
+    }
+  }
+  Graph g = file->failed ? NULL : file->g;
+  pthread_mutex_unlock(&file->lock);
+  return g;
+}
+
+/* order a fresh copy of <g> with <heuristic> (MCS breaking ties
+    by <tie>) and fill in <run>,
+    return the width or -1 if the graph could not be copied */
+int benchmark_run_once(Graph g, int heuristic, mcs_tie tie, struct perf_counters *perf,
+                       struct bench_run *run)
+{
+  /* graph_copy only reads the original, so the jobs of
+      a file can copy it at the same time */
+  Graph copy = graph_copy(g);
+  if (copy == NULL)
+    return -1;
+  if (perf)
+    perf_counters_start(perf);
+  double start = timing_now();
+  int width;
+  switch (heuristic)
+  {
+  case 0:
+    width = graph_order_degree(copy);
+    break;
+  case 1:
+    width = graph_order_fillin(copy);
+    break;
+  case 2:
+    width = graph_order_mcs(copy, tie);
+    break;
+  default:
+    width = graph_order_amd(copy);
+    break;
+  }
+  run->time = timing_now() - start;
+  if (perf)
+    perf_counters_stop(perf, run->counters);
+  else
+  {
+    for (int c = 0; c < PERF_COUNTERS; c++)
+      run->counters[c] = -1;
+  }
+  run->phases = graph_ordering_times(copy);
+  graph_destroy(copy);
+  return width;
+}
+
+int compare_run_time(const void *a, const void *b)
+{
+  double x = ((const struct bench_run *)a)->time;
+  double y = ((const struct bench_run *)b)->time;
+  return (x > y) - (x < y);
+}
+
+/* store the statistics of the <count> runs in <file> */
+void benchmark_statistics(struct bench_file *file, int heuristic,
+                          struct bench_run *runs, int count)
+{
+  qsort(runs, count, sizeof(struct bench_run), compare_run_time);
+  double sum = 0;
+  for (int i = 0; i < count; i++)
+    sum += runs[i].time;
+  double mean = sum / count;
+  double squares = 0;
+  for (int i = 0; i < count; i++)
+    squares += (runs[i].time - mean) * (runs[i].time - mean);
+
+  file->time_min[heuristic] = runs[0].time;
+  if (count % 2)
+    file->time[heuristic] = runs[count / 2].time;
+  else
+    file->time[heuristic] = (runs[count / 2 - 1].time + runs[count / 2].time) / 2;
+  /* nearest rank */
+  int rank = (95 * count + 99) / 100;
+  file->time_p95[heuristic] = runs[rank > 0 ? rank - 1 : 0].time;
+  file->time_stddev[heuristic] = count > 1 ? sqrt(squares / (count - 1)) : 0;
+
+  struct bench_run *median = &runs[(count - 1) / 2];
+  file->phases[heuristic] = median->phases;
+  memcpy(file->counters[heuristic], median->counters, sizeof(median->counters));
+}
+
+/* compute the lower bound of the graph of <file> once,
+    return 0 if it failed */
+char benchmark_lower_bound(struct bench_file *file, Graph g)
+{
+  /* graph_lower_bound works on its own clone of g */
+  double start = timing_now();
+  int bound = graph_lower_bound(g, lb_best);
+  double time = timing_now() - start;
+  /* the treewidth is that of the kernel or the bound of the reductions */
+  if (bound >= 0 && file->kernel_n >= 0 && file->reduction_low > bound)
+    bound = file->reduction_low;
+  pthread_mutex_lock(&file->lock);
+  file->lower_bound = bound;
+  file->lower_bound_time = time;
+  pthread_mutex_unlock(&file->lock);
+  return bound >= 0;
+}
+
+/* release the graph of <file> after its last job and report the file */
+void benchmark_job_done(struct bench_queue *queue, struct bench_file *file, char failed)
+{
+  pthread_mutex_lock(&file->lock);
+  if (failed)
+    file->failed = 1;
+  char done = --file->remaining == 0;
+  if (done)
+  {
+    /* the last job of a file releases the graph */
+    graph_destroy(file->g);
+    file->g = NULL;
+  }
+  pthread_mutex_unlock(&file->lock);
+
+  if (!done)
+    return;
+  if (file->failed)
+  {
+    fprintf(stderr, "Error processing input file %s\n", file->name);
+    atomic_fetch_add(&queue->failed, 1);
+  }
+  else
+  {
+    printf("Analyzed file %s\n", file->name);
+    fflush(stdout);
+  }
+}
+
+/* run a single heuristic on copies of the graph of <file> */
+void benchmark_job(struct bench_queue *queue, struct bench_file *file, int heuristic)
+{
+  const struct benchmark_options *options = queue->options;
+  int width = -1;
+  char failed = 0;
+  struct bench_run *runs = (struct bench_run *)malloc(sizeof(struct bench_run) * options->repeats);
+  Graph g = benchmark_import(file, options);
+  if (g && runs)
+  {
+    /* the counters count the calling thread, so they
+        are opened by the job itself */
+    struct perf_counters perf;
+    if (options->use_counters)
+      perf_counters_open(&perf);
+    struct perf_counters *counters = options->use_counters ? &perf : NULL;
+
+    struct bench_run warmup;
+    for (int i = 0; i < options->warmups && !failed; i++)
+      failed = benchmark_run_once(g, heuristic, options->mcs_tie, counters, &warmup) < 0;
+    for (int i = 0; i < options->repeats && !failed; i++)
+    {
+      width = benchmark_run_once(g, heuristic, options->mcs_tie, counters, &runs[i]);
+      failed = width < 0;
+    }
+    if (options->use_counters)
+      perf_counters_close(&perf);
+  }
+  else if (g)
+    failed = 1;
+
+  if (!failed && g)
+  {
+    pthread_mutex_lock(&file->lock);
+    if (file->kernel_n >= 0 && file->prefix_width > width)
+      width = file->prefix_width;
+    file->width[heuristic] = width;
+    benchmark_statistics(file, heuristic, runs, options->repeats);
+    pthread_mutex_unlock(&file->lock);
+  }
+  free(runs);
+  benchmark_job_done(queue, file, failed);
+}
+
+/* pin the calling thread to one of the cpus of the queue */
+void benchmark_pin(struct bench_queue *queue, int index)
+{
+#ifdef __linux__
+  if (queue->cpu_count == 0)
+    return;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(queue->cpus[index % queue->cpu_count], &set);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+    fprintf(stderr, "Warning: could not pin benchmark thread %d\n", index);
+#else
+  (void)queue;
+  (void)index;
+#endif
+}
+
+void *benchmark_worker(void *arg)
+{
+  struct bench_worker *worker = (struct bench_worker *)arg;
+  struct bench_queue *queue = worker->queue;
+  if (queue->options->pin)
+    benchmark_pin(queue, worker->index);
+  int jobs = queue->count * BENCHMARK_JOBS;
+  int job;
+  while ((job = atomic_fetch_add(&queue->next_job, 1)) < jobs)
+  {
+    struct bench_file *file = &queue->files[job / BENCHMARK_JOBS];
+    if (job % BENCHMARK_JOBS < BENCHMARK_HEURISTICS)
+    {
+      benchmark_job(queue, file, job % BENCHMARK_JOBS);
+      continue;
+    }
+    Graph g = benchmark_import(file, queue->options);
+    benchmark_job_done(queue, file, !g || !benchmark_lower_bound(file, g));
+  }
+  return NULL;
+}
+
+/* largest files first, ties by name so the schedule is deterministic */
+int compare_size_descending(const void *a, const void *b)
+{
+  const struct bench_file *x = (const struct bench_file *)a;
+  const struct bench_file *y = (const struct bench_file *)b;
+  if (x->size != y->size)
+    return x->size < y->size ? 1 : -1;
+  return strcmp(x->name, y->name);
+}
+
+int compare_name(const void *a, const void *b)
+{
+  return strcmp(((const struct bench_file *)a)->name,
+                ((const struct bench_file *)b)->name);
+}
+
+/* write the results of a file as a line of the result file */
+void benchmark_print(FILE *resultfile, struct bench_file *file, int repeats)
+{
+  fprintf(resultfile, "%s", file->name);
+  for (int h = 0; h < BENCHMARK_HEURISTICS; h++)
+    fprintf(resultfile, ",%d,%.9f", file->width[h], file->time[h]);
+  fprintf(resultfile, ",%d,%.9f", file->lower_bound, file->lower_bound_time);
+  fprintf(resultfile, ",%.9f", file->import_time);
+  if (file->kernel_n >= 0)
+    fprintf(resultfile, ",%d,%.9f", file->kernel_n, file->reduction_time);
+  else
+    fprintf(resultfile, ",,");
+  for (int h = 0; h < BENCHMARK_HEURISTICS; h++)
+    fprintf(resultfile, ",%.9f,%.9f,%.9f", file->phases[h].initial,
+            file->phases[h].ordering, file->phases[h].width);
+  fprintf(resultfile, ",%d", repeats);
+  for (int h = 0; h < BENCHMARK_HEURISTICS; h++)
+    fprintf(resultfile, ",%.9f,%.9f,%.9f", file->time_min[h],
+            file->time_p95[h], file->time_stddev[h]);
+  /* counters that were not measured stay empty */
+  for (int h = 0; h < BENCHMARK_HEURISTICS; h++)
+    for (int c = 0; c < PERF_COUNTERS; c++)
+    {
+      if (file->counters[h][c] < 0)
+        fprintf(resultfile, ",");
+      else
+        fprintf(resultfile, ",%lld", file->counters[h][c]);
+    }
+  fprintf(resultfile, "\n");
+}
+
+/* ------------------------ baseline ---------------------------- */
+
+struct baseline_entry
+{
+  char name[FILENAME_MAX_LENGTH];
+  double time[BENCHMARK_HEURISTICS]; /* -1 if missing */
+};
+
+struct benchmark_baseline
+{
+  struct baseline_entry *entries; /* sorted by name */
+  int count;
+};
+
+/* split <line> at commas in place, return the number of fields */
+int split_fields(char *line, char **fields, int max)
+{
+  int count = 0;
+  line[strcspn(line, "\r\n")] = 0;
+  while (count < max)
+  {
+    fields[count++] = line;
+    char *comma = strchr(line, ',');
+    if (comma == NULL)
+      break;
+    *comma = 0;
+    line = comma + 1;
+  }
+  return count;
+}
+
+int compare_entry(const void *a, const void *b)
+{
+  return strcmp(((const struct baseline_entry *)a)->name,
+                ((const struct baseline_entry *)b)->name);
+}
+
+struct benchmark_baseline *benchmark_baseline_load(FILE *fptr)
+{
+  char *line = NULL;
+  size_t line_len = 0;
+  char *fields[BASELINE_MAX_COLUMNS];
+  if (getline(&line, &line_len, fptr) < 0)
+  {
+    free(line);
+    return NULL;
+  }
+  /* find the columns of the file name and the (median) times,
+      this also works for files written by older versions */
+  int name_column = -1;
+  int time_column[BENCHMARK_HEURISTICS];
+  int columns = split_fields(line, fields, BASELINE_MAX_COLUMNS);
+  for (int h = 0; h < BENCHMARK_HEURISTICS; h++)
+  {
+    char title[64];
+    snprintf(title, sizeof(title), "Time %s", BENCHMARK_NAMES[h]);
+    time_column[h] = -1;
+    for (int i = 0; i < columns; i++)
+    {
+      if (strcmp(fields[i], title) == 0)
+        time_column[h] = i;
+      if (strcmp(fields[i], "Filename") == 0)
+        name_column = i;
+    }
+  }
+  if (name_column < 0)
+  {
+    free(line);
+    return NULL;
+  }
+
+  struct benchmark_baseline *baseline = malloc(sizeof(struct benchmark_baseline));
+  int capacity = 64;
+  if (baseline)
+    baseline->entries = malloc(sizeof(struct baseline_entry) * capacity);
+  if (!baseline || !baseline->entries)
+  {
+    free(baseline);
+    free(line);
+    return NULL;
+  }
+  baseline->count = 0;
+  while (getline(&line, &line_len, fptr) >= 0)
+  {
+    int count = split_fields(line, fields, BASELINE_MAX_COLUMNS);
+    if (count <= name_column)
+      continue;
+    if (baseline->count == capacity)
+    {
+      capacity *= 2;
+      struct baseline_entry *grown = realloc(baseline->entries, sizeof(struct baseline_entry) * capacity);
+      if (!grown)
+      {
+        benchmark_baseline_free(baseline);
+        free(line);
+        return NULL;
+      }
+      baseline->entries = grown;
+    }
+    struct baseline_entry *entry = &baseline->entries[baseline->count++];
+    snprintf(entry->name, FILENAME_MAX_LENGTH, "%s", fields[name_column]);
+    for (int h = 0; h < BENCHMARK_HEURISTICS; h++)
+    {
+      entry->time[h] = -1;
+      if (time_column[h] >= 0 && time_column[h] < count && fields[time_column[h]][0])
+        entry->time[h] = strtod(fields[time_column[h]], NULL);
+    }
+  }
+  free(line);
+  qsort(baseline->entries, baseline->count, sizeof(struct baseline_entry), compare_entry);
+  return baseline;
+}
+
+void benchmark_baseline_free(struct benchmark_baseline *baseline)
+{
+  if (!baseline)
+    return;
+  free(baseline->entries);
+  free(baseline);
+}
+
+/* report heuristics of <file> that got slower than in the
+    baseline, return their number */
+int benchmark_compare(struct bench_file *file, const struct benchmark_options *options)
+{
+  struct baseline_entry key;
+  snprintf(key.name, FILENAME_MAX_LENGTH, "%s", file->name);
+  struct baseline_entry *entry = bsearch(&key, options->baseline->entries, options->baseline->count,
+                                         sizeof(struct baseline_entry), compare_entry);
+  if (!entry)
+    return 0;
+  int regressions = 0;
+  for (int h = 0; h < BENCHMARK_HEURISTICS; h++)
+  {
+    if (entry->time[h] <= 0)
+      continue;
+    double change = (file->time[h] - entry->time[h]) / entry->time[h] * 100;
+    if (change > options->threshold && file->time[h] - entry->time[h] >= BENCHMARK_REGRESSION_FLOOR)
+    {
+      fprintf(stderr, "Regression in %s (%s): %.6f s -> %.6f s (%+.1f%%)\n",
+              file->name, BENCHMARK_NAMES[h], entry->time[h], file->time[h], change);
+      regressions++;
+    }
+  }
+  return regressions;
+}
+
+/* ------------------------- running ---------------------------- */
+
+/* Run all heuristics on the <count> files and append a line per
+    file to <resultfile>, sorted by file name.
+    return the number of files that could not be processed */
+int benchmark(struct bench_file *files, int count, FILE *resultfile,
+              const struct benchmark_options *options, int *regressions)
+{
+  qsort(files, count, sizeof(struct bench_file), compare_size_descending);
+  for (int i = 0; i < count; i++)
+  {
+    pthread_mutex_init(&files[i].lock, NULL);
+    files[i].g = NULL;
+    files[i].imported = 0;
+    files[i].failed = 0;
+    files[i].remaining = BENCHMARK_JOBS;
+    files[i].import_time = 0;
+    files[i].kernel_n = -1;
+    files[i].prefix_width = 0;
+    files[i].reduction_low = 0;
+    files[i].reduction_time = 0;
+  }
+
+  struct bench_queue queue;
+  queue.files = files;
+  queue.count = count;
+  queue.options = options;
+  queue.cpus = NULL;
+  queue.cpu_count = 0;
+  atomic_init(&queue.next_job, 0);
+  atomic_init(&queue.failed, 0);
+#ifdef __linux__
+  /* take the cpus before pinning the main thread,
+      the other threads would inherit its affinity */
+  cpu_set_t allowed;
+  if (options->pin && sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+  {
+    queue.cpus = (int *)malloc(sizeof(int) * CPU_SETSIZE);
+    for (int cpu = 0; queue.cpus && cpu < CPU_SETSIZE; cpu++)
+    {
+      if (CPU_ISSET(cpu, &allowed))
+        queue.cpus[queue.cpu_count++] = cpu;
+    }
+  }
+#endif
+
+  /* the main thread works as well */
+  struct bench_worker *workers = (struct bench_worker *)malloc(sizeof(struct bench_worker) * options->threads);
+  int started = 1;
+  struct bench_worker main_worker = {&queue, 0, pthread_self()};
+  for (int i = 1; workers && i < options->threads; i++)
+  {
+    workers[i].queue = &queue;
+    workers[i].index = i;
+    if (pthread_create(&workers[i].thread, NULL, benchmark_worker, &workers[i]) != 0)
+    {
+      perror("Error starting benchmark thread");
+      break;
+    }
+    started++;
+  }
+  benchmark_worker(&main_worker);
+  for (int i = 1; i < started; i++)
+    pthread_join(workers[i].thread, NULL);
+  free(workers);
+  free(queue.cpus);
+
+  /* write the results in an order that does not depend
+      on the scheduling */
+  qsort(files, count, sizeof(struct bench_file), compare_name);
+  *regressions = 0;
+  for (int i = 0; i < count; i++)
+  {
+    pthread_mutex_destroy(&files[i].lock);
+    if (files[i].failed)
+      continue;
+    benchmark_print(resultfile, &files[i], options->repeats);
+    if (options->baseline)
+      *regressions += benchmark_compare(&files[i], options);
+  }
+  fflush(resultfile);
+  return atomic_load(&queue.failed);
+}
+
+int benchmark_run(FILE *inputfiles, FILE *resultfile,
+                  const struct benchmark_options *options, int *regressions)
+{
+  /* Collect the entries in input file list, the graphs are
+      imported by the benchmark jobs */
+  char filename[FILENAME_MAX_LENGTH];
+  int failed = 0;
+  int count = 0, capacity = 64;
+  *regressions = 0;
+  struct bench_file *files = (struct bench_file *)malloc(sizeof(struct bench_file) * capacity);
+  if (files == NULL)
+    return -1;
+  errno = 0;
+  while (fgets(filename, FILENAME_MAX_LENGTH, inputfiles) != NULL)
+  {
+    /* trim leading newline*/
+    filename[strcspn(filename, "\n")] = 0;
+    struct stat info;
+    if (stat(filename, &info) != 0)
+    {
+      fprintf(stderr, "Error opening file %s: ", filename);
+      perror("");
+      errno = 0;
+      failed++;
+      continue;
+    }
+    if (count == capacity)
+    {
+      capacity *= 2;
+      struct bench_file *grown = (struct bench_file *)realloc(files, sizeof(struct bench_file) * capacity);
+      if (grown == NULL)
+      {
+        free(files);
+        return -1;
+      }
+      files = grown;
+    }
+    strcpy(files[count].name, filename);
+    files[count].size = info.st_size;
+    count++;
+  }
+  /* Check if we reached end or there was an error */
+  if (errno)
+  {
+    free(files);
+    return -1;
+  }
+  failed += benchmark(files, count, resultfile, options, regressions);
+  free(files);
+  return failed;
+}
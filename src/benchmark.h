@@ -0,0 +1,60 @@
+/* Benchmark mode: run the heuristics on a list of graphs
+    and collect widths, timings and hardware counters in
+    results.csv.
+*/
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <stdio.h>
+
+#include "graph.h"
+
+#define FILENAME_MAX_LENGTH 50
+
+/* results of an earlier benchmark to compare against */
+struct benchmark_baseline;
+
+struct benchmark_options
+{
+  representation rep;
+  int threads;       /* number of worker threads */
+  int repeats;       /* measured runs of each heuristic */
+  int warmups;       /* runs before the measured ones, discarded */
+  char pin;          /* pin every worker thread to its own core */
+  char use_counters; /* record hardware counters */
+  char cache;        /* import through the binary cache, see graph_import_path */
+  char reduce;       /* order the kernel of the safe reductions, see reduce.h */
+  mcs_tie mcs_tie;   /* tie break of MCS */
+  struct benchmark_baseline *baseline; /* NULL if there is none */
+  double threshold;  /* a median time more than <threshold> percent above
+                        the baseline counts as regression */
+};
+
+/* A median time also has to exceed the baseline by at least this many
+    seconds to count as regression. Below it the noise of the timer
+    dominates, e.g. 5 to 7 microseconds would be 40% slower. */
+#define BENCHMARK_REGRESSION_FLOOR 0.001
+
+/* write the header of the result file */
+void print_file_header(FILE *fptr);
+
+/* return 1 if <fptr> (opened for reading) starts with the
+    header print_file_header writes */
+char file_header_matches(FILE *fptr);
+
+/* Run the benchmark on the graphs listed (one file name per line)
+    in <inputfiles> and append a line per graph to <resultfile>,
+    sorted by file name. The number of slower heuristics compared
+    to the baseline is written to <regressions>.
+    return the number of files that could not be processed,
+    -1 if the list could not be read */
+int benchmark_run(FILE *inputfiles, FILE *resultfile,
+                  const struct benchmark_options *options, int *regressions);
+
+/* read the median times of a result file written earlier,
+    return NULL if it could not be read */
+struct benchmark_baseline *benchmark_baseline_load(FILE *fptr);
+
+void benchmark_baseline_free(struct benchmark_baseline *baseline);
+
+#endif
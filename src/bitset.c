@@ -0,0 +1,791 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bitset.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BITSET_X86 1
+#include <immintrin.h>
+#endif
+
+/* One implementation of every operation for a certain
+    instruction set level */
+struct bitset_kernels
+{
+    const char *name;
+    void (*op_or)(char *result, const char *a, const char *b, int size);
+    void (*op_and)(char *result, const char *a, const char *b, int size);
+    void (*op_and_not)(char *result, const char *a, const char *b, int size);
+    void (*op_uncommon)(char *a_not_b, char *b_not_a, const char *a, const char *b, int size);
+    void (*op_common_uncommon)(char *common, char *a_not_b, char *b_not_a,
+                               const char *a, const char *b, int size);
+    int (*popcount)(const char *pointer, int size);
+    int (*count_and_not)(const char *a, const char *b, int size);
+    int (*count_and)(const char *a, const char *b, int size);
+};
+
+/* ------------------------- scalar ------------------------------ */
+
+/* The rows are processed in 64 bit words. memcpy keeps this
+    free of alignment and aliasing problems, compilers turn
+    it into plain loads and stores. */
+static inline uint64_t load64(const char *pointer)
+{
+    uint64_t value;
+    memcpy(&value, pointer, sizeof(value));
+    return value;
+}
+
+static inline void store64(char *pointer, uint64_t value)
+{
+    memcpy(pointer, &value, sizeof(value));
+}
+
+static inline int popcount64_swar(uint64_t i)
+{
+    i = i - ((i >> 1) & 0x5555555555555555ULL);                         // add pairs of bits
+    i = (i & 0x3333333333333333ULL) + ((i >> 2) & 0x3333333333333333ULL); // quads
+    i = (i + (i >> 4)) & 0x0F0F0F0F0F0F0F0FULL;                         // groups of 8
+    return (int)((i * 0x0101010101010101ULL) >> 56);                    // horizontal sum of bytes
+}
+
+static inline int popcount8(uint8_t byte)
+{
+    static const uint8_t NIBBLE_LOOKUP[16] =
+        {
+            0, 1, 1, 2, 1, 2, 2, 3,
+            1, 2, 2, 3, 2, 3, 3, 4
+        };
+    return NIBBLE_LOOKUP[byte & 0x0F] + NIBBLE_LOOKUP[byte >> 4];
+}
+
+/* The scalar loops start at byte <start>, so the vector
+    versions can use them for whatever is left at the end. */
+static void scalar_or_from(char *result, const char *a, const char *b, int start, int size)
+{
+    int i = start;
+    for (; i + 8 <= size; i += 8)
+        store64(result + i, load64(a + i) | load64(b + i));
+    for (; i < size; i++)
+        result[i] = a[i] | b[i];
+}
+
+static void scalar_and_from(char *result, const char *a, const char *b, int start, int size)
+{
+    int i = start;
+    for (; i + 8 <= size; i += 8)
+        store64(result + i, load64(a + i) & load64(b + i));
+    for (; i < size; i++)
+        result[i] = a[i] & b[i];
+}
+
+static void scalar_and_not_from(char *result, const char *a, const char *b, int start, int size)
+{
+    int i = start;
+    for (; i + 8 <= size; i += 8)
+        store64(result + i, load64(a + i) & ~load64(b + i));
+    for (; i < size; i++)
+        result[i] = a[i] & ~b[i];
+}
+
+static void scalar_uncommon_from(char *a_not_b, char *b_not_a, const char *a, const char *b,
+                                 int start, int size)
+{
+    int i = start;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t x = load64(a + i), y = load64(b + i);
+        store64(a_not_b + i, x & ~y);
+        store64(b_not_a + i, ~x & y);
+    }
+    for (; i < size; i++)
+    {
+        a_not_b[i] = a[i] & ~b[i];
+        b_not_a[i] = ~a[i] & b[i];
+    }
+}
+
+static void scalar_common_uncommon_from(char *common, char *a_not_b, char *b_not_a,
+                                        const char *a, const char *b, int start, int size)
+{
+    int i = start;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t x = load64(a + i), y = load64(b + i);
+        store64(common + i, x & y);
+        store64(a_not_b + i, x & ~y);
+        store64(b_not_a + i, ~x & y);
+    }
+    for (; i < size; i++)
+    {
+        common[i] = a[i] & b[i];
+        a_not_b[i] = a[i] & ~b[i];
+        b_not_a[i] = ~a[i] & b[i];
+    }
+}
+
+/* the remaining bytes from <start> are counted one by one */
+static int scalar_popcount_tail(const char *a, const char *b, int mode, int start, int size)
+{
+    int result = 0;
+    for (int i = start; i < size; i++)
+    {
+        uint8_t byte = (uint8_t)a[i];
+        if (mode == 1)
+            byte &= (uint8_t)~b[i];
+        else if (mode == 2)
+            byte &= (uint8_t)b[i];
+        result += popcount8(byte);
+    }
+    return result;
+}
+
+static void scalar_or(char *result, const char *a, const char *b, int size)
+{
+    scalar_or_from(result, a, b, 0, size);
+}
+
+static void scalar_and(char *result, const char *a, const char *b, int size)
+{
+    scalar_and_from(result, a, b, 0, size);
+}
+
+static void scalar_and_not(char *result, const char *a, const char *b, int size)
+{
+    scalar_and_not_from(result, a, b, 0, size);
+}
+
+static void scalar_uncommon(char *a_not_b, char *b_not_a, const char *a, const char *b, int size)
+{
+    scalar_uncommon_from(a_not_b, b_not_a, a, b, 0, size);
+}
+
+static void scalar_common_uncommon(char *common, char *a_not_b, char *b_not_a,
+                                   const char *a, const char *b, int size)
+{
+    scalar_common_uncommon_from(common, a_not_b, b_not_a, a, b, 0, size);
+}
+
+static int scalar_popcount(const char *pointer, int size)
+{
+    int result = 0;
+    int i = 0;
+    for (; i + 8 <= size; i += 8)
+        result += popcount64_swar(load64(pointer + i));
+    return result + scalar_popcount_tail(pointer, NULL, 0, i, size);
+}
+
+static int scalar_count_and_not(const char *a, const char *b, int size)
+{
+    int result = 0;
+    int i = 0;
+    for (; i + 8 <= size; i += 8)
+        result += popcount64_swar(load64(a + i) & ~load64(b + i));
+    return result + scalar_popcount_tail(a, b, 1, i, size);
+}
+
+static int scalar_count_and(const char *a, const char *b, int size)
+{
+    int result = 0;
+    int i = 0;
+    for (; i + 8 <= size; i += 8)
+        result += popcount64_swar(load64(a + i) & load64(b + i));
+    return result + scalar_popcount_tail(a, b, 2, i, size);
+}
+
+static const struct bitset_kernels scalar_kernels = {
+    "scalar",
+    scalar_or, scalar_and, scalar_and_not, scalar_uncommon, scalar_common_uncommon,
+    scalar_popcount, scalar_count_and_not, scalar_count_and};
+
+#ifdef BITSET_X86
+
+/* ---------------------- SSE4.2 + POPCNT ------------------------ */
+
+#define SSE_TARGET __attribute__((target("sse4.2,popcnt")))
+
+SSE_TARGET static void sse_or(char *result, const char *a, const char *b, int size)
+{
+    int i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        _mm_storeu_si128((__m128i *)(result + i), _mm_or_si128(x, y));
+    }
+    scalar_or_from(result, a, b, i, size);
+}
+
+SSE_TARGET static void sse_and(char *result, const char *a, const char *b, int size)
+{
+    int i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        _mm_storeu_si128((__m128i *)(result + i), _mm_and_si128(x, y));
+    }
+    scalar_and_from(result, a, b, i, size);
+}
+
+SSE_TARGET static void sse_and_not(char *result, const char *a, const char *b, int size)
+{
+    int i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        /* andnot negates its first operand */
+        _mm_storeu_si128((__m128i *)(result + i), _mm_andnot_si128(y, x));
+    }
+    scalar_and_not_from(result, a, b, i, size);
+}
+
+SSE_TARGET static void sse_uncommon(char *a_not_b, char *b_not_a, const char *a, const char *b, int size)
+{
+    int i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        _mm_storeu_si128((__m128i *)(a_not_b + i), _mm_andnot_si128(y, x));
+        _mm_storeu_si128((__m128i *)(b_not_a + i), _mm_andnot_si128(x, y));
+    }
+    scalar_uncommon_from(a_not_b, b_not_a, a, b, i, size);
+}
+
+SSE_TARGET static void sse_common_uncommon(char *common, char *a_not_b, char *b_not_a,
+                                           const char *a, const char *b, int size)
+{
+    int i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        _mm_storeu_si128((__m128i *)(common + i), _mm_and_si128(x, y));
+        _mm_storeu_si128((__m128i *)(a_not_b + i), _mm_andnot_si128(y, x));
+        _mm_storeu_si128((__m128i *)(b_not_a + i), _mm_andnot_si128(x, y));
+    }
+    scalar_common_uncommon_from(common, a_not_b, b_not_a, a, b, i, size);
+}
+
+SSE_TARGET static int sse_popcount(const char *pointer, int size)
+{
+    long long result = 0;
+    int i = 0;
+    for (; i + 8 <= size; i += 8)
+        result += _mm_popcnt_u64(load64(pointer + i));
+    return (int)result + scalar_popcount_tail(pointer, NULL, 0, i, size);
+}
+
+SSE_TARGET static int sse_count_and_not(const char *a, const char *b, int size)
+{
+    long long result = 0;
+    int i = 0;
+    for (; i + 8 <= size; i += 8)
+        result += _mm_popcnt_u64(load64(a + i) & ~load64(b + i));
+    return (int)result + scalar_popcount_tail(a, b, 1, i, size);
+}
+
+SSE_TARGET static int sse_count_and(const char *a, const char *b, int size)
+{
+    long long result = 0;
+    int i = 0;
+    for (; i + 8 <= size; i += 8)
+        result += _mm_popcnt_u64(load64(a + i) & load64(b + i));
+    return (int)result + scalar_popcount_tail(a, b, 2, i, size);
+}
+
+static const struct bitset_kernels sse_kernels = {
+    "sse4.2",
+    sse_or, sse_and, sse_and_not, sse_uncommon, sse_common_uncommon,
+    sse_popcount, sse_count_and_not, sse_count_and};
+
+/* --------------------------- AVX2 ------------------------------ */
+
+#define AVX2_TARGET __attribute__((target("avx2,popcnt")))
+
+AVX2_TARGET static void avx2_or(char *result, const char *a, const char *b, int size)
+{
+    int i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+        _mm256_storeu_si256((__m256i *)(result + i), _mm256_or_si256(x, y));
+    }
+    scalar_or_from(result, a, b, i, size);
+}
+
+AVX2_TARGET static void avx2_and(char *result, const char *a, const char *b, int size)
+{
+    int i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+        _mm256_storeu_si256((__m256i *)(result + i), _mm256_and_si256(x, y));
+    }
+    scalar_and_from(result, a, b, i, size);
+}
+
+AVX2_TARGET static void avx2_and_not(char *result, const char *a, const char *b, int size)
+{
+    int i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+        _mm256_storeu_si256((__m256i *)(result + i), _mm256_andnot_si256(y, x));
+    }
+    scalar_and_not_from(result, a, b, i, size);
+}
+
+AVX2_TARGET static void avx2_uncommon(char *a_not_b, char *b_not_a, const char *a, const char *b, int size)
+{
+    int i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+        _mm256_storeu_si256((__m256i *)(a_not_b + i), _mm256_andnot_si256(y, x));
+        _mm256_storeu_si256((__m256i *)(b_not_a + i), _mm256_andnot_si256(x, y));
+    }
+    scalar_uncommon_from(a_not_b, b_not_a, a, b, i, size);
+}
+
+AVX2_TARGET static void avx2_common_uncommon(char *common, char *a_not_b, char *b_not_a,
+                                             const char *a, const char *b, int size)
+{
+    int i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+        _mm256_storeu_si256((__m256i *)(common + i), _mm256_and_si256(x, y));
+        _mm256_storeu_si256((__m256i *)(a_not_b + i), _mm256_andnot_si256(y, x));
+        _mm256_storeu_si256((__m256i *)(b_not_a + i), _mm256_andnot_si256(x, y));
+    }
+    scalar_common_uncommon_from(common, a_not_b, b_not_a, a, b, i, size);
+}
+
+/* Count the bits of every byte with a nibble lookup table
+    (Mula's method) and sum the bytes up into four 64 bit
+    counters with sad. */
+AVX2_TARGET static inline __m256i avx2_popcount_bytes(__m256i v)
+{
+    const __m256i lookup = _mm256_setr_epi8(
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0F);
+    __m256i low = _mm256_and_si256(v, low_mask);
+    __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    return _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low),
+                           _mm256_shuffle_epi8(lookup, high));
+}
+
+AVX2_TARGET static inline long long avx2_horizontal_sum(__m256i counters)
+{
+    return _mm256_extract_epi64(counters, 0) + _mm256_extract_epi64(counters, 1) +
+           _mm256_extract_epi64(counters, 2) + _mm256_extract_epi64(counters, 3);
+}
+
+/* mode 0: popcount(a), 1: popcount(a & ~b), 2: popcount(a & b) */
+AVX2_TARGET static inline int avx2_count(const char *a, const char *b, int mode, int size)
+{
+    __m256i counters = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        if (mode == 1)
+            x = _mm256_andnot_si256(_mm256_loadu_si256((const __m256i *)(b + i)), x);
+        else if (mode == 2)
+            x = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(b + i)), x);
+        counters = _mm256_add_epi64(counters,
+                                    _mm256_sad_epu8(avx2_popcount_bytes(x), _mm256_setzero_si256()));
+    }
+    long long result = avx2_horizontal_sum(counters);
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t x = load64(a + i);
+        if (mode == 1)
+            x &= ~load64(b + i);
+        else if (mode == 2)
+            x &= load64(b + i);
+        result += _mm_popcnt_u64(x);
+    }
+    return (int)result + scalar_popcount_tail(a, b, mode, i, size);
+}
+
+AVX2_TARGET static int avx2_popcount(const char *pointer, int size)
+{
+    return avx2_count(pointer, NULL, 0, size);
+}
+
+AVX2_TARGET static int avx2_count_and_not(const char *a, const char *b, int size)
+{
+    return avx2_count(a, b, 1, size);
+}
+
+AVX2_TARGET static int avx2_count_and(const char *a, const char *b, int size)
+{
+    return avx2_count(a, b, 2, size);
+}
+
+static const struct bitset_kernels avx2_kernels = {
+    "avx2",
+    avx2_or, avx2_and, avx2_and_not, avx2_uncommon, avx2_common_uncommon,
+    avx2_popcount, avx2_count_and_not, avx2_count_and};
+
+/* ------------------------- AVX-512 ----------------------------- */
+
+#define AVX512_TARGET __attribute__((target("avx512f,avx512vpopcntdq,popcnt")))
+
+AVX512_TARGET static void avx512_or(char *result, const char *a, const char *b, int size)
+{
+    int i = 0;
+    for (; i + 64 <= size; i += 64)
+    {
+        __m512i x = _mm512_loadu_si512((const void *)(a + i));
+        __m512i y = _mm512_loadu_si512((const void *)(b + i));
+        _mm512_storeu_si512((void *)(result + i), _mm512_or_si512(x, y));
+    }
+    scalar_or_from(result, a, b, i, size);
+}
+
+AVX512_TARGET static void avx512_and(char *result, const char *a, const char *b, int size)
+{
+    int i = 0;
+    for (; i + 64 <= size; i += 64)
+    {
+        __m512i x = _mm512_loadu_si512((const void *)(a + i));
+        __m512i y = _mm512_loadu_si512((const void *)(b + i));
+        _mm512_storeu_si512((void *)(result + i), _mm512_and_si512(x, y));
+    }
+    scalar_and_from(result, a, b, i, size);
+}
+
+AVX512_TARGET static void avx512_and_not(char *result, const char *a, const char *b, int size)
+{
+    int i = 0;
+    for (; i + 64 <= size; i += 64)
+    {
+        __m512i x = _mm512_loadu_si512((const void *)(a + i));
+        __m512i y = _mm512_loadu_si512((const void *)(b + i));
+        _mm512_storeu_si512((void *)(result + i), _mm512_andnot_si512(y, x));
+    }
+    scalar_and_not_from(result, a, b, i, size);
+}
+
+AVX512_TARGET static void avx512_uncommon(char *a_not_b, char *b_not_a, const char *a, const char *b, int size)
+{
+    int i = 0;
+    for (; i + 64 <= size; i += 64)
+    {
+        __m512i x = _mm512_loadu_si512((const void *)(a + i));
+        __m512i y = _mm512_loadu_si512((const void *)(b + i));
+        _mm512_storeu_si512((void *)(a_not_b + i), _mm512_andnot_si512(y, x));
+        _mm512_storeu_si512((void *)(b_not_a + i), _mm512_andnot_si512(x, y));
+    }
+    scalar_uncommon_from(a_not_b, b_not_a, a, b, i, size);
+}
+
+AVX512_TARGET static void avx512_common_uncommon(char *common, char *a_not_b, char *b_not_a,
+                                                 const char *a, const char *b, int size)
+{
+    int i = 0;
+    for (; i + 64 <= size; i += 64)
+    {
+        __m512i x = _mm512_loadu_si512((const void *)(a + i));
+        __m512i y = _mm512_loadu_si512((const void *)(b + i));
+        _mm512_storeu_si512((void *)(common + i), _mm512_and_si512(x, y));
+        _mm512_storeu_si512((void *)(a_not_b + i), _mm512_andnot_si512(y, x));
+        _mm512_storeu_si512((void *)(b_not_a + i), _mm512_andnot_si512(x, y));
+    }
+    scalar_common_uncommon_from(common, a_not_b, b_not_a, a, b, i, size);
+}
+
+/* mode 0: popcount(a), 1: popcount(a & ~b), 2: popcount(a & b) */
+AVX512_TARGET static inline int avx512_count(const char *a, const char *b, int mode, int size)
+{
+    __m512i counters = _mm512_setzero_si512();
+    int i = 0;
+    for (; i + 64 <= size; i += 64)
+    {
+        __m512i x = _mm512_loadu_si512((const void *)(a + i));
+        if (mode == 1)
+            x = _mm512_andnot_si512(_mm512_loadu_si512((const void *)(b + i)), x);
+        else if (mode == 2)
+            x = _mm512_and_si512(_mm512_loadu_si512((const void *)(b + i)), x);
+        counters = _mm512_add_epi64(counters, _mm512_popcnt_epi64(x));
+    }
+    long long result = _mm512_reduce_add_epi64(counters);
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t x = load64(a + i);
+        if (mode == 1)
+            x &= ~load64(b + i);
+        else if (mode == 2)
+            x &= load64(b + i);
+        result += _mm_popcnt_u64(x);
+    }
+    return (int)result + scalar_popcount_tail(a, b, mode, i, size);
+}
+
+AVX512_TARGET static int avx512_popcount(const char *pointer, int size)
+{
+    return avx512_count(pointer, NULL, 0, size);
+}
+
+AVX512_TARGET static int avx512_count_and_not(const char *a, const char *b, int size)
+{
+    return avx512_count(a, b, 1, size);
+}
+
+AVX512_TARGET static int avx512_count_and(const char *a, const char *b, int size)
+{
+    return avx512_count(a, b, 2, size);
+}
+
+static const struct bitset_kernels avx512_kernels = {
+    "avx512",
+    avx512_or, avx512_and, avx512_and_not, avx512_uncommon, avx512_common_uncommon,
+    avx512_popcount, avx512_count_and_not, avx512_count_and};
+
+#endif /* BITSET_X86 */
+
+/* ------------------------- dispatch ---------------------------- */
+
+static const struct bitset_kernels *kernels = &scalar_kernels;
+
+#ifdef BITSET_X86
+/* Runs before main, so the kernels never change while
+    the graphs are being worked on */
+__attribute__((constructor)) static void bitset_select_kernels(void)
+{
+    const struct bitset_kernels *available[4];
+    int count = 0;
+    __builtin_cpu_init();
+    available[count++] = &scalar_kernels;
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt"))
+        available[count++] = &sse_kernels;
+    if (count == 2 && __builtin_cpu_supports("avx2"))
+        available[count++] = &avx2_kernels;
+    if (count == 3 && __builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("avx512vpopcntdq"))
+        available[count++] = &avx512_kernels;
+    kernels = available[count - 1];
+
+    /* allow to go down to a lower level, e.g. for comparisons */
+    const char *requested = getenv("TREEDECOMP_SIMD");
+    if (!requested)
+        return;
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp(requested, available[i]->name) == 0)
+        {
+            kernels = available[i];
+            return;
+        }
+    }
+    /* a comparison must not silently measure the wrong kernels */
+    fprintf(stderr, "Warning: TREEDECOMP_SIMD=%s is unknown or not supported by this CPU, using %s (available:",
+            requested, kernels->name);
+    for (int i = 0; i < count; i++)
+        fprintf(stderr, " %s", available[i]->name);
+    fprintf(stderr, ")\n");
+}
+#else
+/* only the scalar kernels are built, see bitset_select_kernels above */
+__attribute__((constructor)) static void bitset_check_request(void)
+{
+    const char *requested = getenv("TREEDECOMP_SIMD");
+    if (requested && strcmp(requested, scalar_kernels.name) != 0)
+        fprintf(stderr, "Warning: TREEDECOMP_SIMD=%s is not available in this build, using scalar (available: scalar)\n",
+                requested);
+}
+#endif
+
+const char *bitset_kernel_name(void)
+{
+    return kernels->name;
+}
+
+void bitwise_or(char *result, char *a, char *b, int size)
+{
+    kernels->op_or(result, a, b, size);
+}
+
+void bitwise_and(char *result, char *a, char *b, int size)
+{
+    kernels->op_and(result, a, b, size);
+}
+
+void calculate_uncommon_neigbours(char *a_not_b, char *b_not_a, char *a, char *b, int size)
+{
+    if (!a_not_b)
+        kernels->op_and_not(b_not_a, b, a, size);
+    else if (!b_not_a)
+        kernels->op_and_not(a_not_b, a, b, size);
+    else
+        kernels->op_uncommon(a_not_b, b_not_a, a, b, size);
+}
+
+void calculate_common_uncommon_neighbours(char *common, char *a_not_b, char *b_not_a, char *a, char *b, int size)
+{
+    kernels->op_common_uncommon(common, a_not_b, b_not_a, a, b, size);
+}
+
+int number_of_set_bits(char *pointer, int size)
+{
+    return kernels->popcount(pointer, size);
+}
+
+int count_and_not(char *a, char *b, int size)
+{
+    return kernels->count_and_not(a, b, size);
+}
+
+int count_and(char *a, char *b, int size)
+{
+    return kernels->count_and(a, b, size);
+}
+
+/* ------------------------- scanning ---------------------------- */
+
+/* load the <index>'th 64 bit word of a vector, so that bit i
+    of the vector is bit i%64 of the word */
+static inline uint64_t load_word(const char *bits, int index)
+{
+    uint64_t value = load64(bits + (size_t)index * 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+/* index of the lowest set bit, <word> must not be 0 */
+static inline int lowest_bit(uint64_t word)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int index = 0;
+    while (!(word & 1))
+    {
+        word >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+int bitset_next(const char *bits, int start, int size)
+{
+    int words = size / 8;
+    if (start < 0)
+        start = 0;
+    int w = start / 64;
+    if (w >= words)
+        return -1;
+    /* ignore the bits before start in the first word */
+    uint64_t word = load_word(bits, w) & (~0ULL << (start % 64));
+    while (!word)
+    {
+        if (++w >= words)
+            return -1;
+        word = load_word(bits, w);
+    }
+    return w * 64 + lowest_bit(word);
+}
+
+int bitset_to_list(const char *bits, int size, int *buffer)
+{
+    int words = size / 8;
+    int count = 0;
+    for (int w = 0; w < words; w++)
+    {
+        uint64_t word = load_word(bits, w);
+        while (word)
+        {
+            buffer[count++] = w * 64 + lowest_bit(word);
+            word &= word - 1; /* clear the lowest set bit */
+        }
+    }
+    return count;
+}
+
+int bitset_summary_size(int size)
+{
+    return (size / 8 + 63) / 64;
+}
+
+void bitset_summary_build(uint64_t *summary, const char *bits, int size)
+{
+    int words = size / 8;
+    memset(summary, 0, sizeof(uint64_t) * bitset_summary_size(size));
+    for (int w = 0; w < words; w++)
+    {
+        if (load_word(bits, w))
+            summary[w / 64] |= 1ULL << (w % 64);
+    }
+}
+
+int bitset_next_summary(const char *bits, const uint64_t *summary, int start, int size)
+{
+    int words = size / 8;
+    if (start < 0)
+        start = 0;
+    int w = start / 64;
+    if (w >= words)
+        return -1;
+    uint64_t word = load_word(bits, w) & (~0ULL << (start % 64));
+    if (word)
+        return w * 64 + lowest_bit(word);
+
+    /* find the next non-empty word with the summary */
+    if (++w >= words)
+        return -1;
+    int summary_words = bitset_summary_size(size);
+    int s = w / 64;
+    uint64_t candidates = summary[s] & (~0ULL << (w % 64));
+    for (;;)
+    {
+        while (!candidates)
+        {
+            if (++s >= summary_words)
+                return -1;
+            candidates = summary[s];
+        }
+        w = s * 64 + lowest_bit(candidates);
+        word = load_word(bits, w);
+        if (word)
+            return w * 64 + lowest_bit(word);
+        candidates &= candidates - 1;
+    }
+}
+
+int bitset_to_list_summary(const char *bits, const uint64_t *summary, int size, int *buffer)
+{
+    int summary_words = bitset_summary_size(size);
+    int count = 0;
+    for (int s = 0; s < summary_words; s++)
+    {
+        uint64_t candidates = summary[s];
+        while (candidates)
+        {
+            int w = s * 64 + lowest_bit(candidates);
+            candidates &= candidates - 1;
+            uint64_t word = load_word(bits, w);
+            while (word)
+            {
+                buffer[count++] = w * 64 + lowest_bit(word);
+                word &= word - 1;
+            }
+        }
+    }
+    return count;
+}
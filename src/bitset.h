@@ -0,0 +1,81 @@
+/* Operations on bit vectors of <size> bytes, as used for the
+    rows of the adjacency matrix.
+    The implementation is picked at startup from what the CPU
+    supports: scalar, SSE4.2 with POPCNT, AVX2 or AVX-512 with
+    VPOPCNTDQ. Set the environment variable TREEDECOMP_SIMD to
+    one of "scalar", "sse4.2", "avx2" or "avx512" to use a
+    lower level than the best one available; a name that is unknown
+    or not supported by the CPU is reported on stderr with the
+    available ones and the best level is used.
+*/
+#ifndef BITSET_H
+#define BITSET_H
+
+#include <stdint.h>
+
+/* result = a | b, result may be a or b */
+void bitwise_or(char *result, char *a, char *b, int size);
+
+/* result = a & b */
+void bitwise_and(char *result, char *a, char *b, int size);
+
+/* Given 2 adjacency lists calculates
+    - a_not_b: vertices that are neighbours of a but not b
+    - b_not_a: vertices that are neighbours of b but not a
+    Either of the results may be NULL if it is not needed.
+*/
+void calculate_uncommon_neigbours(char *a_not_b, char *b_not_a, char *a, char *b, int size);
+
+/* Given 2 adjacency lists calculates
+    - common: vertices that are neigbours to both vertices
+    - a_not_b: vertices that are neighbours of a but not b
+    - b_not_a: vertices that are neighbours of b but not a
+*/
+void calculate_common_uncommon_neighbours(char *common, char *a_not_b, char *b_not_a, char *a, char *b, int size);
+
+/* return the number of bits set */
+int number_of_set_bits(char *pointer, int size);
+
+/* return the number of bits set in a but not in b,
+    i.e. the size of a & ~b without writing it anywhere */
+int count_and_not(char *a, char *b, int size);
+
+/* return the number of bits set in both a and b */
+int count_and(char *a, char *b, int size);
+
+/* name of the implementation in use */
+const char *bitset_kernel_name(void);
+
+/*  Scanning for set bits.
+    Bit i of a vector is bit i%8 of byte i/8 (least significant
+    bit first), which makes it bit i%64 of the i/64'th 64 bit
+    word. The functions below work on whole words, so <size>
+    has to be a multiple of 8 bytes.
+*/
+
+/* return the index of the first set bit at or after <start>,
+    -1 if there is none */
+int bitset_next(const char *bits, int start, int size);
+
+/* write the indices of all set bits to <buffer> in ascending
+    order and return their number. The caller is responsible
+    for sizing the buffer correctly! */
+int bitset_to_list(const char *bits, int size, int *buffer);
+
+/*  A summary of a bit vector has one bit per 64 bit word of
+    the vector, which is set if the word may be non-zero.
+    A cleared bit guarantees an empty word, so the functions
+    using a summary skip 4096 bits per empty summary word.
+*/
+
+/* number of 64 bit words in the summary of a vector of <size> bytes */
+int bitset_summary_size(int size);
+
+/* compute the exact summary of <bits> */
+void bitset_summary_build(uint64_t *summary, const char *bits, int size);
+
+/* bitset_next and bitset_to_list using the summary of <bits> */
+int bitset_next_summary(const char *bits, const uint64_t *summary, int start, int size);
+int bitset_to_list_summary(const char *bits, const uint64_t *summary, int size, int *buffer);
+
+#endif
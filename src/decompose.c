@@ -0,0 +1,540 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "decompose.h"
+#include "timing.h"
+
+/* the neighbour lists of the graph, read once */
+struct adjacency
+{
+    int *offsets;
+    int *items;
+};
+
+/* The parts in the order their vertices are eliminated. Part i
+    eliminates vertices[offsets[i]..offsets[i+1]) and is ordered
+    together with its clique separator
+    separators[separator_offsets[i]..separator_offsets[i+1]),
+    both lists are ascending. Every vertex is eliminated by
+    exactly one part, so there are n entries in vertices. */
+struct parts
+{
+    int count;
+    int *offsets;
+    int *vertices;
+    int *separator_offsets;
+    int *separators;
+    int separators_cap;
+};
+
+/* the orderings of the parts shared by the threads */
+struct decompose_job
+{
+    Graph g;
+    strategy heuristic;
+    mcs_tie tie;
+    const struct parts *parts;
+    const int *schedule;   /* the parts by decreasing size */
+    int *ordering;         /* the stitched ordering of g */
+    int *widths;           /* of every part, -1 if it failed */
+    atomic_int next;
+};
+
+static int compare_int(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static char adjacency_build(Graph g, int n, struct adjacency *a)
+{
+    a->offsets = (int *)malloc(sizeof(int) * (n + 1));
+    if (!a->offsets)
+        return 0;
+    a->offsets[0] = 0;
+    for (int v = 0; v < n; v++)
+        a->offsets[v + 1] = a->offsets[v] + graph_degree(g, v);
+    a->items = (int *)malloc(sizeof(int) * (a->offsets[n] > 0 ? a->offsets[n] : 1));
+    if (!a->items)
+        return 0;
+    for (int v = 0; v < n; v++)
+        graph_neighbours(g, v, a->items + a->offsets[v]);
+    return 1;
+}
+
+/* append the part eliminating the <len> vertices of <part> (at
+    parts->offsets[parts->count] already) with <separator> */
+static char parts_add(struct parts *parts, int len, const int *separator, int separator_len)
+{
+    int start = parts->offsets[parts->count];
+    qsort(parts->vertices + start, len, sizeof(int), compare_int);
+    int used = parts->separator_offsets[parts->count];
+    if (used + separator_len > parts->separators_cap)
+    {
+        int cap = 2 * parts->separators_cap;
+        if (cap < used + separator_len)
+            cap = used + separator_len;
+        int *grown = (int *)realloc(parts->separators, sizeof(int) * cap);
+        if (!grown)
+            return 0;
+        parts->separators = grown;
+        parts->separators_cap = cap;
+    }
+    /* components have no separator, and no list of it */
+    if (separator_len > 0)
+    {
+        memcpy(parts->separators + used, separator, sizeof(int) * separator_len);
+        qsort(parts->separators + used, separator_len, sizeof(int), compare_int);
+    }
+    parts->count++;
+    parts->offsets[parts->count] = start + len;
+    parts->separator_offsets[parts->count] = used + separator_len;
+    return 1;
+}
+
+/* write the component number of every vertex to <component>,
+    return the number of components */
+static int find_components(const struct adjacency *a, int n, int *component, int *queue)
+{
+    int count = 0;
+    for (int v = 0; v < n; v++)
+        component[v] = -1;
+    for (int v = 0; v < n; v++)
+    {
+        if (component[v] >= 0)
+            continue;
+        int head = 0, tail = 0;
+        queue[tail++] = v;
+        component[v] = count;
+        while (head < tail)
+        {
+            int x = queue[head++];
+            for (int j = a->offsets[x]; j < a->offsets[x + 1]; j++)
+            {
+                if (component[a->items[j]] < 0)
+                {
+                    component[a->items[j]] = count;
+                    queue[tail++] = a->items[j];
+                }
+            }
+        }
+        count++;
+    }
+    return count;
+}
+
+/* one part per component, without separators */
+static char split_components(const int *component, int components, int n, struct parts *parts)
+{
+    int *fill = (int *)calloc(components + 1, sizeof(int));
+    if (!fill)
+        return 0;
+    for (int v = 0; v < n; v++)
+        fill[component[v] + 1]++;
+    for (int c = 0; c < components; c++)
+        fill[c + 1] += fill[c];
+    /* ascending within every component */
+    for (int v = 0; v < n; v++)
+        parts->vertices[fill[component[v]]++] = v;
+    char ok = 1;
+    for (int c = 0; c < components && ok; c++)
+        ok = parts_add(parts, fill[c] - parts->offsets[c], NULL, 0);
+    free(fill);
+    return ok;
+}
+
+/* MCS-M: the vertices in order of elimination (the reverse of the
+    search) and for every vertex its neighbours in the minimal
+    triangulation that are eliminated later (madj). A vertex whose
+    label is not larger than the one of the vertex numbered before
+    generates a minimal separator. */
+struct mcsm
+{
+    int *elimination;
+    char *generator;
+    int *madj_head;   /* linked lists of madj entries */
+    int *madj_next;
+    int *madj_item;
+    size_t madj_len;
+    size_t madj_cap;
+};
+
+static char mcsm_add(struct mcsm *m, int vertex, int later)
+{
+    if (m->madj_len == m->madj_cap)
+    {
+        size_t cap = m->madj_cap ? 2 * m->madj_cap : 1024;
+        int *next = (int *)realloc(m->madj_next, sizeof(int) * cap);
+        if (next)
+            m->madj_next = next;
+        int *item = (int *)realloc(m->madj_item, sizeof(int) * cap);
+        if (item)
+            m->madj_item = item;
+        if (!next || !item)
+            return 0;
+        m->madj_cap = cap;
+    }
+    m->madj_item[m->madj_len] = later;
+    m->madj_next[m->madj_len] = m->madj_head[vertex];
+    m->madj_head[vertex] = (int)m->madj_len++;
+    return 1;
+}
+
+/* The vertex y gets a higher label when x is numbered if a path
+    from x to y leads over unnumbered vertices of smaller labels
+    only. These paths are searched label by label, every vertex is
+    kept in the bucket of the smallest largest label on a path to it. */
+static char mcsm_run(const struct adjacency *a, int n, struct mcsm *m)
+{
+    int *label = (int *)calloc(n + 1, sizeof(int));
+    char *numbered = (char *)calloc(n + 1, 1);
+    int *reached = (int *)malloc(sizeof(int) * (n + 1));
+    int *bucket = (int *)malloc(sizeof(int) * (n + 1));
+    int *link = (int *)malloc(sizeof(int) * (n + 1));
+    int *raised = (int *)malloc(sizeof(int) * (n + 1));
+    char ok = label && numbered && reached && bucket && link && raised;
+    int max_label = 0;
+    int previous = -1;
+    for (int v = 0; ok && v < n; v++)
+    {
+        reached[v] = -1;
+        bucket[v] = -1;
+    }
+    for (int i = n - 1; ok && i >= 0; i--)
+    {
+        int x = -1;
+        for (int v = 0; v < n; v++)
+        {
+            if (!numbered[v] && (x < 0 || label[v] > label[x]))
+                x = v;
+        }
+        m->generator[x] = label[x] <= previous;
+        previous = label[x];
+        numbered[x] = 1;
+        m->elimination[i] = x;
+        reached[x] = i;
+
+        int raised_len = 0;
+        for (int j = a->offsets[x]; j < a->offsets[x + 1]; j++)
+        {
+            int y = a->items[j];
+            if (numbered[y])
+                continue;
+            reached[y] = i;
+            link[y] = bucket[label[y]];
+            bucket[label[y]] = y;
+            raised[raised_len++] = y;
+        }
+        for (int l = 0; l <= max_label; l++)
+        {
+            while (bucket[l] >= 0)
+            {
+                int z = bucket[l];
+                bucket[l] = link[z];
+                for (int j = a->offsets[z]; j < a->offsets[z + 1]; j++)
+                {
+                    int w = a->items[j];
+                    if (numbered[w] || reached[w] == i)
+                        continue;
+                    reached[w] = i;
+                    int to = l;
+                    if (label[w] > l)
+                    {
+                        to = label[w];
+                        raised[raised_len++] = w;
+                    }
+                    link[w] = bucket[to];
+                    bucket[to] = w;
+                }
+            }
+        }
+        for (int k = 0; k < raised_len && ok; k++)
+        {
+            int y = raised[k];
+            if (++label[y] > max_label)
+                max_label = label[y];
+            ok = mcsm_add(m, y, x);
+        }
+    }
+    free(label);
+    free(numbered);
+    free(reached);
+    free(bucket);
+    free(link);
+    free(raised);
+    return ok;
+}
+
+/* The atoms algorithm: in the order of elimination, a generator x
+    whose madj(x) (of the vertices left) is a clique of g separates
+    the component C of the vertices left minus madj(x) that holds x
+    from the rest, unless C and madj(x) are all that is left. C is
+    eliminated as a part and removed. The vertices left at the end
+    form the last part. */
+static char split_atoms(Graph g, const struct mcsm *m, int n, const struct adjacency *a,
+                        struct parts *parts, int *separator_count)
+{
+    char *state = (char *)calloc(n + 1, 1); /* 1 removed, 2 in the separator */
+    int *separator = (int *)malloc(sizeof(int) * (n + 1));
+    char ok = state && separator;
+    int left = n;
+    *separator_count = 0;
+    for (int k = 0; ok && k < n; k++)
+    {
+        int x = m->elimination[k];
+        if (!m->generator[x] || state[x])
+            continue;
+        int len = 0;
+        for (int e = m->madj_head[x]; e >= 0; e = m->madj_next[e])
+        {
+            if (!state[m->madj_item[e]])
+                separator[len++] = m->madj_item[e];
+        }
+        char clique = 1;
+        for (int i = 0; i < len && clique; i++)
+        {
+            for (int j = i + 1; j < len && clique; j++)
+                clique = graph_has_edge(g, separator[i], separator[j]);
+        }
+        if (!clique)
+            continue;
+        for (int i = 0; i < len; i++)
+            state[separator[i]] = 2;
+
+        /* the component of x, collected where its part goes */
+        int *queue = parts->vertices + parts->offsets[parts->count];
+        int head = 0, tail = 0;
+        queue[tail++] = x;
+        state[x] = 1;
+        while (head < tail)
+        {
+            int z = queue[head++];
+            for (int j = a->offsets[z]; j < a->offsets[z + 1]; j++)
+            {
+                if (!state[a->items[j]])
+                {
+                    state[a->items[j]] = 1;
+                    queue[tail++] = a->items[j];
+                }
+            }
+        }
+        for (int i = 0; i < len; i++)
+            state[separator[i]] = 0;
+        if (tail + len == left)
+        {
+            /* nothing separated, undo */
+            for (int i = 0; i < tail; i++)
+                state[queue[i]] = 0;
+            continue;
+        }
+        left -= tail;
+        ok = parts_add(parts, tail, separator, len);
+        if (len > 0)
+            (*separator_count)++;
+    }
+    if (ok && left > 0)
+    {
+        int len = 0;
+        int *rest = parts->vertices + parts->offsets[parts->count];
+        for (int v = 0; v < n; v++)
+        {
+            if (!state[v])
+                rest[len++] = v;
+        }
+        ok = parts_add(parts, len, NULL, 0);
+    }
+    free(state);
+    free(separator);
+    return ok;
+}
+
+/* order one part, its vertices before the separator go to
+    the stitched ordering. <map> is the scratch map of
+    graph_induced of the thread. */
+static int decompose_part(struct decompose_job *job, int part, int *map)
+{
+    const struct parts *parts = job->parts;
+    int len = parts->offsets[part + 1] - parts->offsets[part];
+    int separator_len = parts->separator_offsets[part + 1] - parts->separator_offsets[part];
+    const int *own = parts->vertices + parts->offsets[part];
+    const int *separator = parts->separators + parts->separator_offsets[part];
+    int size = len + separator_len;
+    int *members = (int *)malloc(sizeof(int) * (size + 1));
+    int *local = (int *)malloc(sizeof(int) * (separator_len + 1));
+    int *ordering = (int *)malloc(sizeof(int) * (size + 1));
+    Graph h = NULL;
+    int width = -1;
+    if (members && local && ordering)
+    {
+        /* merge the two ascending lists */
+        int i = 0, j = 0, k = 0;
+        while (i < len || j < separator_len)
+        {
+            if (j == separator_len || (i < len && own[i] < separator[j]))
+                members[k++] = own[i++];
+            else
+            {
+                local[j] = k;
+                members[k++] = separator[j++];
+            }
+        }
+        h = graph_induced(job->g, members, size, map);
+    }
+    if (h)
+    {
+        width = graph_order(h, job->heuristic, job->tie);
+        if (width >= 0 && !graph_ordering_clique_last(h, local, separator_len, ordering))
+            width = -1;
+    }
+    if (width >= 0)
+    {
+        for (int k = 0; k < len; k++)
+            job->ordering[parts->offsets[part] + k] = members[ordering[k]];
+    }
+    graph_destroy(h);
+    free(members);
+    free(local);
+    free(ordering);
+    return width;
+}
+
+static void *decompose_worker(void *arg)
+{
+    struct decompose_job *job = (struct decompose_job *)arg;
+    /* one map for all parts of the thread, instead of one of the
+        size of the whole graph per part */
+    int n = graph_vertex_count(job->g);
+    int *map = (int *)malloc(sizeof(int) * (n + 1));
+    if (!map)
+        return NULL; /* the others take over its parts */
+    for (int v = 0; v < n; v++)
+        map[v] = -1;
+    int next;
+    while ((next = atomic_fetch_add(&job->next, 1)) < job->parts->count)
+    {
+        int part = job->schedule[next];
+        job->widths[part] = decompose_part(job, part, map);
+    }
+    free(map);
+    return NULL;
+}
+
+static int compare_long(const void *a, const void *b)
+{
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+char decompose_order(Graph g, strategy heuristic, mcs_tie tie, int threads,
+                     struct decomposition *result)
+{
+    int n = graph_vertex_count(g);
+    memset(result, 0, sizeof(struct decomposition));
+    result->width = -1;
+    double split_start = timing_now();
+
+    struct adjacency a = {NULL, NULL};
+    struct parts parts = {0, NULL, NULL, NULL, NULL, 0};
+    struct mcsm m = {NULL, NULL, NULL, NULL, NULL, 0, 0};
+    parts.offsets = (int *)calloc(n + 2, sizeof(int));
+    parts.separator_offsets = (int *)calloc(n + 2, sizeof(int));
+    parts.vertices = (int *)malloc(sizeof(int) * (n + 1));
+    int *component = (int *)malloc(sizeof(int) * (n + 1));
+    int *ordering = (int *)malloc(sizeof(int) * (n + 1));
+    int *schedule = (int *)malloc(sizeof(int) * (n + 1));
+    int *widths = (int *)malloc(sizeof(int) * (n + 1));
+    long long *keys = (long long *)malloc(sizeof(long long) * (n + 1));
+    char ok = parts.offsets && parts.separator_offsets && parts.vertices &&
+              component && ordering && schedule && widths && keys && adjacency_build(g, n, &a);
+    if (ok)
+    {
+        /* the schedule is the queue of the search here */
+        result->components = find_components(&a, n, component, schedule);
+        result->atoms = (long long)n * (n + a.offsets[n]) <= DECOMPOSE_MAX_WORK;
+        if (result->atoms)
+        {
+            m.elimination = (int *)malloc(sizeof(int) * (n + 1));
+            m.generator = (char *)calloc(n + 1, 1);
+            m.madj_head = (int *)malloc(sizeof(int) * (n + 1));
+            ok = m.elimination && m.generator && m.madj_head;
+            for (int v = 0; ok && v < n; v++)
+                m.madj_head[v] = -1;
+            ok = ok && mcsm_run(&a, n, &m) &&
+                 split_atoms(g, &m, n, &a, &parts, &result->separators);
+        }
+        else
+            ok = split_components(component, result->components, n, &parts);
+    }
+    free(m.elimination);
+    free(m.generator);
+    free(m.madj_head);
+    free(m.madj_next);
+    free(m.madj_item);
+    free(a.offsets);
+    free(a.items);
+    free(component);
+    result->time_split = timing_now() - split_start;
+
+    if (ok)
+    {
+        result->parts = parts.count;
+        /* the largest parts first, so they do not end up last */
+        for (int i = 0; i < parts.count; i++)
+        {
+            int size = parts.offsets[i + 1] - parts.offsets[i] +
+                       parts.separator_offsets[i + 1] - parts.separator_offsets[i];
+            if (size > result->largest)
+                result->largest = size;
+            keys[i] = (long long)(n - size) << 32 | i;
+        }
+        qsort(keys, parts.count, sizeof(long long), compare_long);
+        for (int i = 0; i < parts.count; i++)
+        {
+            schedule[i] = (int)(keys[i] & 0xffffffff);
+            widths[i] = -1; /* until the part is ordered */
+        }
+
+        struct decompose_job job;
+        job.g = g;
+        job.heuristic = heuristic;
+        job.tie = tie;
+        job.parts = &parts;
+        job.schedule = schedule;
+        job.ordering = ordering;
+        job.widths = widths;
+        atomic_init(&job.next, 0);
+        if (threads > parts.count)
+            threads = parts.count;
+        pthread_t *workers = threads > 1 ? (pthread_t *)malloc(sizeof(pthread_t) * threads) : NULL;
+        int started = 0;
+        for (; workers && started < threads - 1; started++)
+        {
+            if (pthread_create(&workers[started], NULL, decompose_worker, &job) != 0)
+                break; /* the others take over its parts */
+        }
+        decompose_worker(&job);
+        for (int i = 0; i < started; i++)
+            pthread_join(workers[i], NULL);
+        free(workers);
+
+        for (int i = 0; i < parts.count && ok; i++)
+            ok = widths[i] >= 0;
+    }
+    if (ok)
+    {
+        graph_set_ordering(g, ordering);
+        result->width = n > 0 ? graph_ordering_width(g) : 0;
+    }
+    free(parts.offsets);
+    free(parts.vertices);
+    free(parts.separator_offsets);
+    free(parts.separators);
+    free(ordering);
+    free(schedule);
+    free(widths);
+    free(keys);
+    return ok;
+}
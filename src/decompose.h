@@ -0,0 +1,45 @@
+/* Decomposition of the graph before ordering. The graph is split
+    into its connected components and these into atoms along clique
+    separators: the minimal separators that are cliques are found
+    in the minimal triangulation of MCS-M (Berry, Pogorelcnik and
+    Simonet, "An introduction to clique minimal separator
+    decomposition"). Every tree decomposition has a bag holding
+    a given clique, so the treewidth of the graph is the largest
+    treewidth of its atoms.
+    The atoms are ordered on their own, in parallel. An atom split
+    off along the clique S is ordered with S last (see
+    graph_ordering_clique_last) and its other vertices are
+    eliminated first in the ordering of the graph, which only adds
+    edges within S. The width of the stitched ordering is therefore
+    the largest width of the parts.
+    MCS-M takes O(n m), graphs above DECOMPOSE_MAX_WORK are only
+    split into their components.
+*/
+#ifndef DECOMPOSE_H
+#define DECOMPOSE_H
+
+#include "graph.h"
+
+/* search clique separators only while n * (n + m) stays below this */
+#define DECOMPOSE_MAX_WORK 200000000LL
+
+struct decomposition
+{
+    int parts;        /* ordered separately */
+    int components;
+    int separators;   /* non-empty clique separators split along */
+    char atoms;       /* 0 if the graph was too large for the separator search */
+    int largest;      /* vertices of the largest part */
+    int width;        /* of the stitched ordering */
+    double time_split; /* seconds spent finding the parts */
+};
+
+/* Split g into parts, order each with <heuristic> (MCS ties by <tie>)
+    using <threads> threads and set the stitched ordering as the
+    ordering of g (see graph_set_ordering). g has to be unchanged
+    (not ordered before) and is not altered otherwise.
+    return 1 on success, 0 if a part could not be ordered */
+char decompose_order(Graph g, strategy heuristic, mcs_tie tie, int threads,
+                     struct decomposition *result);
+
+#endif
@@ -0,0 +1,489 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "exact.h"
+#include "bitset.h"
+#include "memo.h"
+#include "timing.h"
+
+/* the deadline is checked every this many nodes */
+#define EXACT_CHECK_INTERVAL 256
+
+/* the state shared by the threads of a search */
+struct exact_shared
+{
+    int n;
+    int words;          /* 64 bit words per row */
+    const uint64_t *rows; /* the graph */
+    const int *degrees;
+    int target;         /* a width that can not be beaten */
+    double deadline;
+    struct memo_table *memo; /* eliminated sets, NULL without a table */
+    atomic_int best_width;
+    int *best;          /* best ordering found, protected by lock */
+    pthread_mutex_t lock;
+    atomic_int next;    /* next branch of the first node that branches */
+    atomic_char halt;   /* the target was reached or the time is up */
+    atomic_char timed_out;
+    atomic_int searched; /* threads that had the memory to search */
+    atomic_llong nodes;
+    atomic_llong memo_hits;
+};
+
+/* state of one thread of the search */
+struct search
+{
+    struct exact_shared *shared;
+    int n;
+    int words;
+    uint64_t *rows;     /* n rows for every level */
+    uint64_t *sets;     /* the eliminated set of every level */
+    int *degrees;       /* n degrees for every level, -1 if eliminated */
+    int *candidates;    /* n entries for every level */
+    uint64_t *scratch;  /* n rows for the lower bound */
+    int *scratch_degrees;
+    int *list;          /* n entries */
+    int *path;          /* the vertices eliminated on the way to the node */
+    long long nodes;
+    long long memo_hits;
+};
+
+static uint64_t *level_rows(struct search *s, int depth)
+{
+    return s->rows + (size_t)depth * s->n * s->words;
+}
+
+static int *level_degrees(struct search *s, int depth)
+{
+    return s->degrees + (size_t)depth * s->n;
+}
+
+static char has_bit(const uint64_t *row, int index)
+{
+    return (row[index >> 6] >> (index & 63)) & 1;
+}
+
+/* eliminate <vertex> from the graph of level <depth>, giving level depth + 1 */
+static void search_eliminate(struct search *s, int depth, int vertex)
+{
+    int n = s->n, words = s->words, size = words * 8;
+    uint64_t *rows = level_rows(s, depth + 1);
+    int *degrees = level_degrees(s, depth + 1);
+    memcpy(rows, level_rows(s, depth), sizeof(uint64_t) * n * words);
+    memcpy(degrees, level_degrees(s, depth), sizeof(int) * n);
+    uint64_t *set = s->sets + (size_t)(depth + 1) * words;
+    memcpy(set, s->sets + (size_t)depth * words, sizeof(uint64_t) * words);
+    set[vertex >> 6] |= 1ULL << (vertex & 63);
+
+    uint64_t *row = rows + (size_t)vertex * words;
+    int len = bitset_to_list((char *)row, size, s->list);
+    for (int i = 0; i < len; i++)
+    {
+        int u = s->list[i];
+        uint64_t *other = rows + (size_t)u * words;
+        bitwise_or((char *)other, (char *)other, (char *)row, size);
+        other[u >> 6] &= ~(1ULL << (u & 63));
+        other[vertex >> 6] &= ~(1ULL << (vertex & 63));
+        degrees[u] = number_of_set_bits((char *)other, size);
+    }
+    memset(row, 0, sizeof(uint64_t) * words);
+    degrees[vertex] = -1;
+}
+
+/* Minor-min-width of the graph of level <depth> with <left>
+    vertices: contract a vertex of minimum degree into its neighbour
+    of minimum degree until the minimum degree can not grow any more.
+    Stops early once the bound reaches <enough>. */
+static int search_lower_bound(struct search *s, int depth, int left, int enough)
+{
+    int n = s->n, words = s->words, size = words * 8;
+    uint64_t *rows = s->scratch;
+    int *degrees = s->scratch_degrees;
+    memcpy(rows, level_rows(s, depth), sizeof(uint64_t) * n * words);
+    memcpy(degrees, level_degrees(s, depth), sizeof(int) * n);
+    int bound = 0;
+    while (left - 1 > bound && bound < enough)
+    {
+        int v = -1;
+        for (int x = 0; x < n; x++)
+        {
+            if (degrees[x] >= 0 && (v < 0 || degrees[x] < degrees[v]))
+                v = x;
+        }
+        if (degrees[v] > bound)
+            bound = degrees[v];
+        uint64_t *row = rows + (size_t)v * words;
+        int len = bitset_to_list((char *)row, size, s->list);
+        int u = -1;
+        for (int i = 0; i < len; i++)
+        {
+            if (u < 0 || degrees[s->list[i]] < degrees[u])
+                u = s->list[i];
+        }
+        /* contract v into u */
+        for (int i = 0; i < len; i++)
+        {
+            int w = s->list[i];
+            uint64_t *other = rows + (size_t)w * words;
+            other[v >> 6] &= ~(1ULL << (v & 63));
+            if (w == u)
+            {
+                degrees[u]--;
+                continue;
+            }
+            if (has_bit(other, u))
+                degrees[w]--;
+            else
+            {
+                other[u >> 6] |= 1ULL << (u & 63);
+                rows[(size_t)u * words + (w >> 6)] |= 1ULL << (w & 63);
+                degrees[u]++;
+            }
+        }
+        memset(row, 0, sizeof(uint64_t) * words);
+        degrees[v] = -1;
+        left--;
+    }
+    return bound;
+}
+
+/* Return a vertex of the graph of level <depth> that can be
+    eliminated without branching: a simplicial one, or an almost
+    simplicial one of degree at most <low>. -1 if there is none.
+    For every neighbour the other neighbours it is not adjacent to
+    are counted, as in reduce.c. */
+static int search_forced(struct search *s, int depth, int low)
+{
+    int n = s->n, words = s->words, size = words * 8;
+    uint64_t *rows = level_rows(s, depth);
+    int *degrees = level_degrees(s, depth);
+    for (int v = 0; v < n; v++)
+    {
+        if (degrees[v] < 0)
+            continue;
+        if (degrees[v] <= 1)
+            return v;
+        uint64_t *row = rows + (size_t)v * words;
+        int len = bitset_to_list((char *)row, size, s->list);
+        long total = 0;
+        int widest = 0;
+        char almost = degrees[v] <= low;
+        for (int i = 0; i < len; i++)
+        {
+            /* the neighbour itself is not in its row */
+            int missing = count_and_not((char *)row, (char *)(rows + (size_t)s->list[i] * words), size) - 1;
+            if ((missing > 0 && !almost) || (missing > 1 && widest > 1))
+            {
+                total = -1;
+                break;
+            }
+            total += missing;
+            if (missing > widest)
+                widest = missing;
+        }
+        if (total == 0 || (almost && total > 0 && total == 2L * widest))
+            return v;
+    }
+    return -1;
+}
+
+/* keep the path to a node of level <depth> followed by its vertices
+    as the best ordering if its width <width> is better */
+static void search_record(struct search *s, int depth, int width)
+{
+    struct exact_shared *shared = s->shared;
+    int *degrees = level_degrees(s, depth);
+    pthread_mutex_lock(&shared->lock);
+    if (width < atomic_load(&shared->best_width))
+    {
+        memcpy(shared->best, s->path, sizeof(int) * depth);
+        for (int v = 0, k = depth; v < s->n; v++)
+        {
+            if (degrees[v] >= 0)
+                shared->best[k++] = v;
+        }
+        atomic_store(&shared->best_width, width);
+        if (width <= shared->target)
+            atomic_store(&shared->halt, 1);
+    }
+    pthread_mutex_unlock(&shared->lock);
+}
+
+/* Bound the node of level <depth> reached at <cost>: write its lower
+    bound to *<low> and return 1 if it has to be branched on, 0 if it
+    can not beat the best width or every ordering of it is optimal
+    (then it is recorded). */
+static char search_bound(struct search *s, int depth, int cost, int *low)
+{
+    int best = atomic_load(&s->shared->best_width);
+    int left = s->n - depth;
+    *low = cost;
+    if (left - 1 > *low)
+    {
+        int bound = search_lower_bound(s, depth, left, best);
+        if (bound > *low)
+            *low = bound;
+    }
+    if (*low >= best)
+        return 0;
+    if (left - 1 <= *low)
+    {
+        /* every ordering of the rest does, the width is low */
+        search_record(s, depth, cost > left - 1 ? cost : left - 1);
+        return 0;
+    }
+    return 1;
+}
+
+/* list the vertices of the node of level <depth> that may be
+    eliminated next, the ones of smaller degree first */
+static int search_candidates(struct search *s, int depth)
+{
+    int *degrees = level_degrees(s, depth);
+    int *candidates = s->candidates + (size_t)depth * s->n;
+    int best = atomic_load(&s->shared->best_width);
+    int count = 0;
+    for (int v = 0; v < s->n; v++)
+    {
+        if (degrees[v] < 0 || degrees[v] >= best)
+            continue;
+        int k = count++;
+        while (k > 0 && degrees[candidates[k - 1]] > degrees[v])
+        {
+            candidates[k] = candidates[k - 1];
+            k--;
+        }
+        candidates[k] = v;
+    }
+    return count;
+}
+
+/* Search the node of level <depth> reached at <cost>, the last vertex
+    eliminated by branching being <last> (-1 if none). */
+static void search_node(struct search *s, int depth, int cost, int last)
+{
+    struct exact_shared *shared = s->shared;
+    if (atomic_load_explicit(&shared->halt, memory_order_relaxed))
+        return;
+    if (++s->nodes % EXACT_CHECK_INTERVAL == 0 && timing_now() > shared->deadline)
+    {
+        atomic_store(&shared->timed_out, 1);
+        atomic_store(&shared->halt, 1);
+        return;
+    }
+    if (shared->memo && memo_table_visit(shared->memo, s->sets + (size_t)depth * s->words, cost))
+    {
+        s->memo_hits++;
+        return;
+    }
+    int low;
+    if (!search_bound(s, depth, cost, &low))
+        return;
+
+    int *degrees = level_degrees(s, depth);
+    int forced = search_forced(s, depth, low);
+    if (forced >= 0)
+    {
+        s->path[depth] = forced;
+        search_eliminate(s, depth, forced);
+        search_node(s, depth + 1, cost > degrees[forced] ? cost : degrees[forced], -1);
+        return;
+    }
+
+    int *candidates = s->candidates + (size_t)depth * s->n;
+    int count = search_candidates(s, depth);
+    const uint64_t *before = last >= 0 ? level_rows(s, depth - 1) + (size_t)last * s->words : NULL;
+    for (int i = 0; i < count && !atomic_load_explicit(&shared->halt, memory_order_relaxed); i++)
+    {
+        int best = atomic_load(&shared->best_width);
+        int v = candidates[i];
+        if (low >= best || degrees[v] >= best)
+            break;
+        /* last and v in the other order give the same node */
+        if (before && v < last && !has_bit(before, v))
+            continue;
+        s->path[depth] = v;
+        search_eliminate(s, depth, v);
+        search_node(s, depth + 1, cost > degrees[v] ? cost : degrees[v], v);
+    }
+}
+
+/* Every thread eliminates the forced vertices from the root on by
+    itself, up to the first node that branches. Its branches are
+    handed out to the threads one by one. */
+static void search_root(struct search *s)
+{
+    struct exact_shared *shared = s->shared;
+    int depth = 0, cost = 0, low;
+    for (;;)
+    {
+        if (!search_bound(s, depth, cost, &low))
+            return;
+        int forced = search_forced(s, depth, low);
+        if (forced < 0)
+            break;
+        int degree = level_degrees(s, depth)[forced];
+        s->path[depth] = forced;
+        search_eliminate(s, depth, forced);
+        cost = cost > degree ? cost : degree;
+        depth++;
+    }
+    int *degrees = level_degrees(s, depth);
+    int *candidates = s->candidates + (size_t)depth * s->n;
+    int count = search_candidates(s, depth);
+    int i;
+    while ((i = atomic_fetch_add(&shared->next, 1)) < count && !atomic_load(&shared->halt))
+    {
+        int best = atomic_load(&shared->best_width);
+        int v = candidates[i];
+        if (low >= best || degrees[v] >= best)
+            continue;
+        s->path[depth] = v;
+        search_eliminate(s, depth, v);
+        search_node(s, depth + 1, cost > degrees[v] ? cost : degrees[v], v);
+    }
+}
+
+static void *search_worker(void *arg)
+{
+    struct exact_shared *shared = (struct exact_shared *)arg;
+    int n = shared->n;
+    size_t level = (size_t)n * shared->words;
+    struct search s;
+    memset(&s, 0, sizeof(struct search));
+    s.shared = shared;
+    s.n = n;
+    s.words = shared->words;
+    s.rows = (uint64_t *)malloc(sizeof(uint64_t) * ((n + 1) * level + 1));
+    s.sets = (uint64_t *)calloc((size_t)(n + 1) * s.words, sizeof(uint64_t));
+    s.degrees = (int *)malloc(sizeof(int) * ((size_t)(n + 1) * n + 1));
+    s.candidates = (int *)malloc(sizeof(int) * ((size_t)(n + 1) * n + 1));
+    s.scratch = (uint64_t *)malloc(sizeof(uint64_t) * (level + 1));
+    s.scratch_degrees = (int *)malloc(sizeof(int) * (n + 1));
+    s.list = (int *)malloc(sizeof(int) * (n + 1));
+    s.path = (int *)malloc(sizeof(int) * (n + 1));
+    /* without memory this thread does no search, the others do */
+    if (s.rows && s.sets && s.degrees && s.candidates && s.scratch &&
+        s.scratch_degrees && s.list && s.path)
+    {
+        memcpy(s.rows, shared->rows, sizeof(uint64_t) * level);
+        memcpy(s.degrees, shared->degrees, sizeof(int) * n);
+        atomic_fetch_add(&shared->searched, 1);
+        search_root(&s);
+        atomic_fetch_add(&shared->nodes, s.nodes);
+        atomic_fetch_add(&shared->memo_hits, s.memo_hits);
+    }
+    free(s.rows);
+    free(s.sets);
+    free(s.degrees);
+    free(s.candidates);
+    free(s.scratch);
+    free(s.scratch_degrees);
+    free(s.list);
+    free(s.path);
+    return NULL;
+}
+
+char exact_order(Graph g, strategy heuristic, mcs_tie tie, int lower_bound,
+                 double limit, size_t memory, int threads, struct exact_result *result)
+{
+    int n = graph_vertex_count(g);
+    memset(result, 0, sizeof(struct exact_result));
+    result->width = -1;
+    if (n > EXACT_MAX_VERTICES)
+        return 0;
+    double start = timing_now();
+
+    struct exact_shared shared;
+    memset(&shared, 0, sizeof(struct exact_shared));
+    shared.n = n;
+    shared.words = (n + 63) / 64 > 0 ? (n + 63) / 64 : 1;
+    shared.best = (int *)malloc(sizeof(int) * (n + 1));
+    Graph clone = graph_clone(g);
+    if (!shared.best || !clone)
+    {
+        free(shared.best);
+        graph_destroy(clone);
+        return 0;
+    }
+    int width = graph_order(clone, heuristic, tie);
+    graph_get_ordering(clone, shared.best);
+    graph_destroy(clone);
+    if (width < 0)
+    {
+        free(shared.best);
+        return 0;
+    }
+    result->heuristic_width = width;
+    result->lower_bound = graph_lower_bound(g, lb_best);
+    shared.target = result->lower_bound > lower_bound ? result->lower_bound : lower_bound;
+    atomic_init(&shared.best_width, width);
+    atomic_init(&shared.next, 0);
+    atomic_init(&shared.halt, 0);
+    atomic_init(&shared.timed_out, 0);
+    atomic_init(&shared.searched, 0);
+    atomic_init(&shared.nodes, 0);
+    atomic_init(&shared.memo_hits, 0);
+    pthread_mutex_init(&shared.lock, NULL);
+
+    uint64_t *rows = (uint64_t *)calloc((size_t)n * shared.words + 1, sizeof(uint64_t));
+    int *degrees = (int *)malloc(sizeof(int) * (n + 1));
+    int *list = (int *)malloc(sizeof(int) * (n + 1));
+    char ok = rows && degrees && list;
+    char searched = 1;
+    if (ok && width > shared.target)
+    {
+        for (int v = 0; v < n; v++)
+        {
+            int len = graph_neighbours(g, v, list);
+            for (int i = 0; i < len; i++)
+                rows[(size_t)v * shared.words + (list[i] >> 6)] |= 1ULL << (list[i] & 63);
+            degrees[v] = len;
+        }
+        shared.rows = rows;
+        shared.degrees = degrees;
+        shared.deadline = start + limit;
+        shared.memo = memo_table_create(shared.words, memory, 1);
+
+        pthread_t *workers = threads > 1 ? (pthread_t *)malloc(sizeof(pthread_t) * threads) : NULL;
+        int started = 0;
+        for (; workers && started < threads - 1; started++)
+        {
+            if (pthread_create(&workers[started], NULL, search_worker, &shared) != 0)
+                break; /* the others take over its branches */
+        }
+        search_worker(&shared);
+        for (int i = 0; i < started; i++)
+            pthread_join(workers[i], NULL);
+        free(workers);
+        searched = atomic_load(&shared.searched) > 0;
+
+        if (shared.memo)
+        {
+            struct memo_stats stats;
+            memo_table_stats(shared.memo, &stats);
+            result->memo_entries = stats.entries;
+            result->memo_evictions = stats.evictions;
+            memo_table_destroy(shared.memo);
+        }
+    }
+    if (ok)
+    {
+        graph_set_ordering(g, shared.best);
+        result->width = atomic_load(&shared.best_width);
+        result->optimal = searched && !atomic_load(&shared.timed_out);
+        result->nodes = atomic_load(&shared.nodes);
+        result->memo_hits = atomic_load(&shared.memo_hits);
+    }
+    result->time = timing_now() - start;
+    pthread_mutex_destroy(&shared.lock);
+    free(rows);
+    free(degrees);
+    free(list);
+    free(shared.best);
+    return ok;
+}
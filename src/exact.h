@@ -0,0 +1,65 @@
+/* Exact treewidth by branch and bound over elimination orderings
+    (in the spirit of QuickBB, Gogate and Dechter), meant for small
+    graphs such as the kernels left by the reductions of reduce.h.
+    The graph left after eliminating a set of vertices does not
+    depend on their order, so a search node is the set of eliminated
+    vertices together with the largest degree upon elimination on the
+    way there (its cost). The adjacency of every level of the search
+    is kept as bit rows, eliminations and degrees use the bitset
+    kernels of bitset.h.
+    Pruning:
+    - the ordering of the heuristic gives the first upper bound
+    - a node is cut off once the larger one of its cost and the
+      minor-min-width lower bound of the graph left reaches the best
+      width found
+    - simplicial vertices, and almost simplicial ones of degree at
+      most that lower bound, are eliminated without branching
+    - of two non-adjacent vertices eliminated one after the other,
+      which give the same graph in either order, only the order with
+      the smaller vertex first is searched
+    - a memo table of the eliminated sets (see memo.h) skips nodes
+      reached before at no higher cost
+    With several threads the branches of the first node that branches
+    are handed out one by one, the threads share the best width and
+    the memo table.
+    The search stops at a time limit or once the best width equals a
+    known lower bound. Without a limit reached the width is optimal.
+*/
+#ifndef EXACT_H
+#define EXACT_H
+
+#include <stddef.h>
+
+#include "graph.h"
+
+/* larger graphs are not searched, the rows of every level of the
+    search take n^3 / 8 bytes */
+#define EXACT_MAX_VERTICES 512
+
+struct exact_result
+{
+    int width;          /* of the best ordering */
+    int heuristic_width; /* of the ordering of the heuristic */
+    int lower_bound;    /* at the root of the search */
+    char optimal;       /* 1 if the search completed, width is the treewidth */
+    long long nodes;    /* search nodes visited */
+    long long memo_hits; /* nodes skipped by the memo table */
+    long long memo_entries; /* eliminated sets stored */
+    long long memo_evictions;
+    double time;        /* seconds spent searching */
+};
+
+/* Search an optimal ordering of g for at most <limit> seconds with
+    <threads> threads, starting from the ordering of <heuristic> (MCS
+    ties by <tie>), with a memo table of at most <memory> bytes. The
+    search ends once the width equals <lower_bound> (-1 if unknown),
+    which has to be a lower bound of the treewidth of g (or of a graph
+    g is the kernel of).
+    g itself has to be unchanged (not ordered before), afterwards it
+    holds the best ordering without the eliminated graph.
+    return 1 on success, 0 if g has more than EXACT_MAX_VERTICES
+    vertices or there was not enough memory */
+char exact_order(Graph g, strategy heuristic, mcs_tie tie, int lower_bound,
+                 double limit, size_t memory, int threads, struct exact_result *result);
+
+#endif
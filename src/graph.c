@@ -6,18 +6,36 @@
 #include <string.h>
 #include <limits.h>
 #include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 #include "graph.h"
-
-#define ALIGNMENT 16
+#include "adjset.h"
+#include "bitset.h"
+#include "arena.h"
+#include "timing.h"
+#include "tdwriter.h"
+#include "amd.h"
+
+/* alignment and size granularity of the matrix rows,
+    a cache line which is also the AVX-512 vector width */
+#define ALIGNMENT 64
 //#define VALIDATE_FILLIN 1
 
+/* With the automatic representation the bit matrix is used
+    whenever it needs at most this many bytes */
+#define DENSE_MAX_BYTES ((size_t)64 << 20)
+
 /* add an undirected edge to an existing graph */
 void graph_add_edge(Graph, int vertex1, int vertex2);
 
 /* delete the edge from <vertex1> to <vertex2> from the graph.
     Call this twice with vertices swapped if you want to delete
-    both directions
+    both directions. Only supported for the bit matrix.
 */
 void graph_delete_edge(Graph g, int vertex1, int vertex2);
 
@@ -26,20 +44,37 @@ void graph_delete_edge(Graph g, int vertex1, int vertex2);
 */
 void graph_delete_vertex(Graph g, int vertex);
 
-/* eliminate a vertex from the graph in the context
-   of elimination orderings (delete vertex and
-   connect its neighbours)*/
-int graph_eliminate_vertex(Graph g, int vertex, int *neighbourhood);
-
-struct node_t
+/*  Edges of a graph in the sparse representation.
+    The edges read at import are kept in compressed sparse
+    row format: the neighbours of vertex i are
+    csr_targets[csr_offsets[i]] to csr_targets[csr_offsets[i+1]-1]
+    in ascending order. Every edge added later (fill-in edges)
+    goes to the sorted set fill[i] instead, so the two parts
+    of a row never overlap.
+    Deleting a vertex does not touch the rows of its neighbours,
+    entries pointing to deleted vertices are skipped when
+    iterating a row instead. The row of a deleted vertex thus
+    still holds all its neighbours at the time of deletion.
+*/
+struct sparse_adjacency
 {
-    int id;              /* id of the node */
-    int degree;          /* number of successors */
-    char is_deleted;     /* deletion flag */
-    char in_set;         /* true if the node is already in ordering */
-    int priority_index;  /* this node is contained in <g->priority->heads[priority_index]>*/
-    struct node_t *next; /* Next member of the priority linked list */
-    struct node_t *prev; /* Previous member of priority linked list */
+    int *csr_offsets;    /* nodes_len + 1 entries */
+    int *csr_targets;    /* csr_offsets[nodes_len] entries */
+    struct adjset *fill; /* one set per vertex */
+    char *deleted;       /* the deletion flags of the graph
+                            (g->is_deleted), not owned */
+
+    /*  Scratch space for set operations on rows. Vertex v
+        is marked in <mark> if mark[v] equals the stamp in
+        use, this way unmarking is free.
+    */
+    int *mark;
+    int *mark_neighbour;
+    int stamp;
+    int *list_vertex;    /* buffers of nodes_len entries for rows */
+    int *list_neighbour;
+    int *list_other;
+    char shared_csr;     /* csr_targets belongs to another graph */
 };
 
 /*  To greatly improve performance, we keep track
@@ -60,8 +95,8 @@ struct node_t
     */
 struct Priority_t
 {
-    struct node_t **heads;
-    struct node_t **tails;
+    int *heads; /* first vertex of each list, -1 if empty */
+    int *tails; /* last vertex of each list, -1 if empty */
     /* max_ptr is the biggest index i where
         <Priority_t->heads[i]> is not empty */
     int max_ptr;
@@ -77,265 +112,293 @@ struct graph
 {
     int n;                 /* number of vertices */
     int m;                 /* number of edges */
-    struct node_t **nodes; /* actual array of vertex pointers */
 
     /* if a vertex is deleted, <n> decreases
         but <nodes_len> stays the same. Since
         deleting a node is simply setting a
-        flag, the valid entries in <nodes> are
+        flag, the valid vertices are
         not necessarily consecutive. Therefore
         iterations over nodes require <nodes_len>
         and checking for the deletion flag.
     */
-    int nodes_len; /* size of nodes array */
-
-    /* We use an adjacency matrix to keep track
+    int nodes_len; /* size of the node arrays */
+
+    /* The data of vertex v is the v'th entry of each of
+        these arrays. All of them live in <node_block>,
+        so they can be copied at once. */
+    int *degree;          /* number of neighbours */
+    int *priority_index;  /* v is contained in <priority->heads[priority_index[v]]> */
+    int *next;            /* next member of the priority list, -1 if none */
+    int *prev;            /* previous member of the priority list, -1 if none */
+    char *is_deleted;     /* deletion flags */
+    char *in_set;         /* true if the node is already in ordering */
+    void *node_block;
+
+    /* For the dense representation we use an
+         adjacency matrix to keep track
          of the edges. Note: This is a bit field.
          A graph has n "rows" of n bits, so approx.
          n/8 chars per row.
          If an edge between u and v exists,
-         the v'th bit in the u'th row is set.
+         the v'th bit in the u'th row is set
+         (bit v%8 of byte v/8, see bitset.h).
+         The rows are stored one after the other in a
+         single block, row v starts at byte
+         v * adjacency_size.
       */
-    char **adjacency_matrix;
+    char *adjacency_matrix;
     int adjacency_size; /* size of adjacency matrix rows */
 
+    /* Summary bitmaps of the rows, one bit per 64 bit word of
+        a row telling if the word is non-empty, so iterating
+        the neighbours of a vertex skips empty regions.
+        The summary of row v starts at
+        row_summary[v * summary_size].
+    */
+    uint64_t *row_summary;
+    int summary_size; /* number of words of a summary */
+
+    representation rep;                /* which of the two is used */
+    struct sparse_adjacency *sparse;   /* edges if <rep> is sparse */
+
     int *ordering; /* holds the ordering produced by an elimination ordering*/
+    /* Graph with all vertices of <ordering> eliminated, so its
+        rows hold the neighbourhoods upon elimination (the bags).
+        This is the graph itself after graph_order_degree and
+        graph_order_fillin, NULL after graph_order_mcs (which does
+        not eliminate, see graph_write_treedecomp) and if no
+        ordering was computed. */
+    struct graph *elimination;
+    int numbering; /* number of the first vertex in the imported file */
 
     struct Priority_t *priority; /* structure for determining the next node
                                     to eliminate */
+    struct ordering_times times; /* phases of the last ordering */
+    int threads; /* threads for the initial priorities, 0 means 1 */
+    char random_ties;       /* see graph_set_random_ties */
+    uint64_t random_state;
+    atomic_int *width_bound; /* see graph_set_width_bound */
+
+    /* Scratch buffers (neighbour lists, temporary rows) are
+        taken from here and released when the function using
+        them returns, so the eliminations of an ordering run
+        do not allocate memory. */
+    struct arena scratch;
     // enum strategy_t *strategy;
 };
 
-/* resize memory and initialize new space to 0 */
-void *realloc_zero(void *pBuffer, size_t oldSize, size_t newSize)
+/* resize an int array and initialize new entries to <value> */
+int *realloc_fill(int *buffer, size_t old_len, size_t new_len, int value)
 {
-    void *pNew = realloc(pBuffer, newSize);
-    if (newSize > oldSize && pNew)
-    {
-        size_t diff = newSize - oldSize;
-        void *pStart = ((char *)pNew) + oldSize;
-        memset(pStart, 0, diff);
-    }
-    return pNew;
+    int *result = (int *)realloc(buffer, sizeof(int) * new_len);
+    if (!result)
+        return NULL;
+    for (size_t i = old_len; i < new_len; i++)
+        result[i] = value;
+    return result;
+}
+
+/* start of the matrix row of <vertex> */
+static inline char *matrix_row(Graph g, int vertex)
+{
+    return g->adjacency_matrix + (size_t)vertex * g->adjacency_size;
 }
 
 void set_bit(char* pointer, int index, char value) {
     if (value)
     {
-        pointer[index/8] |= 0x1 << (7 - index % 8);
+        pointer[index/8] |= 0x1 << (index % 8);
     }
     else {
-        pointer[index/8] &= ~(0x1 << (7 - index % 8));
+        pointer[index/8] &= ~(0x1 << (index % 8));
     }
 }
 
-void bitwise_or(char *result, char *a, char *b, int size)
+/* summary of the matrix row of <vertex> */
+uint64_t *row_summary(Graph g, int vertex)
 {
-#ifdef AVX
-
-#else
-    for (int i = 0; i < size; i++)
-    {
-        *(result + i) = *(a + i) | *(b + i);
-    }
-#endif
+    return g->row_summary + (size_t)vertex * g->summary_size;
 }
 
-void bitwise_and(char *result, char *a, char *b, int size)
+/* set the bit of <sink> in the matrix row of <source> */
+void matrix_set(Graph g, int source, int sink)
 {
-#ifdef AVX
-
-#else
-    for (int i = 0; i < size; i++)
-    {
-        *(result + i) = *(a + i) & *(b + i);
-    }
-#endif
+    set_bit(matrix_row(g, source), sink, 1);
+    int word = sink / 64;
+    row_summary(g, source)[word / 64] |= 1ULL << (word % 64);
 }
 
-/* Given 2 adjacency lists calculates
-    - a_not_b: vertices that are neighbours of a but not b
-    - b_not_a: vertices that are neighbours of b but not a
-*/
-void calculate_uncommon_neigbours(char *a_not_b, char *b_not_a, char *a, char *b, int size)
+/* clear the bit of <sink> in the matrix row of <source> */
+void matrix_clear(Graph g, int source, int sink)
 {
-#ifdef AVX
-
-#else
-    if (!a_not_b) {
-        for (int i = 0; i < size; i++)
-        {
-            *(b_not_a + i) = ~*(a + i) & *(b + i);
-        }
-        return;
-    }
-    else if (!b_not_a) {
-        for (int i = 0; i < size; i++)
-        {
-            *(a_not_b + i) = *(a + i) & ~*(b + i);
-        }
-        return;
-    }
-    for (int i = 0; i < size; i++)
-    {
-
-        *(a_not_b + i) = *(a + i) & ~*(b + i);
-        *(b_not_a + i) = ~*(a + i) & *(b + i);
-    }
-#endif
+    set_bit(matrix_row(g, source), sink, 0);
+    int word = sink / 64;
+    uint64_t value;
+    memcpy(&value, matrix_row(g, source) + (size_t)word * 8, sizeof(value));
+    if (!value)
+        row_summary(g, source)[word / 64] &= ~(1ULL << (word % 64));
 }
 
-/* Given 2 adjacency lists calculates
-    - common: vertices that are neigbours to both vertices
-    - a_not_b: vertices that are neighbours of a but not b
-    - b_not_a: vertices that are neighbours of b but not a
-*/
-void calculate_common_uncommon_neighbours(char *common, char *a_not_b, char *b_not_a, char *a, char *b, int size)
+/* Get the index of the next neighbour of <vertex> in the
+    bit matrix starting from <start_index>, -1 if there is none */
+int matrix_next_neighbour(Graph g, int vertex, int start_index)
 {
-#ifdef AVX
+    return bitset_next_summary(matrix_row(g, vertex), row_summary(g, vertex),
+                               start_index, g->adjacency_size);
+}
 
-#else
-    for (int i = 0; i < size; i++)
-    {
-        *(common + i) = *(a + i) & *(b + i);
-        *(a_not_b + i) = *(a + i) & ~*(b + i);
-        *(b_not_a + i) = ~*(a + i) & *(b + i);
-    }
-#endif
+/* check if a node exists and is not deleted */
+char node_invalid(Graph g, int node)
+{
+    if (node < 0 ||
+        node >= g->nodes_len ||
+        g->is_deleted[node])
+        return 1;
+    return 0;
 }
 
-int number_of_set_bits(char *ch_pointer, int size)
+/* get <bytes> bytes of scratch memory from the arena of the
+    graph. Release them with arena_reset on g->scratch. */
+void *graph_scratch(Graph g, size_t bytes)
 {
-    int result = 0;
-    /* Since we are only counting bits, we don't care
-        about Endianness here
-    */
-    uint32_t* pointer = (uint32_t*)ch_pointer;
-    int j;
-    for (j = 0; j < size / 4; j++)
+    void *result = arena_alloc(&g->scratch, bytes);
+    if (!result)
     {
-        uint32_t i = pointer[j];
-        i = i - ((i >> 1) & 0x55555555);                // add pairs of bits
-        i = (i & 0x33333333) + ((i >> 2) & 0x33333333); // quads
-        i = (i + (i >> 4)) & 0x0F0F0F0F;                // groups of 8
-        i *= 0x01010101;                                // horizontal sum of bytes
-        result += i >> 24;                                 // return just that top byte (after truncating to 32-bit even when int is wider than uint32_t)
+        fprintf(stderr, "Out of memory allocating %zu bytes of scratch space\n", bytes);
+        abort();
     }
-    if (size%4==0) return result;
+    return result;
+}
 
-    static const uint8_t NIBBLE_LOOKUP [16] =
-        {
-            0, 1, 1, 2, 1, 2, 2, 3, 
-            1, 2, 2, 3, 2, 3, 3, 4
-        };
+/* next number of the random sequence of g (xorshift64*) */
+static uint64_t graph_random(Graph g)
+{
+    uint64_t x = g->random_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    g->random_state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
 
-    for (int k = 0; k < size%4; k++)
+/* write the vertices 0..n-1 in random order to <permutation> */
+static void graph_random_permutation(Graph g, int *permutation, int n)
+{
+    for (int i = 0; i < n; i++)
+        permutation[i] = i;
+    for (int i = n - 1; i > 0; i--)
     {
-        uint8_t byte = ch_pointer[4*j+k];
-        result += NIBBLE_LOOKUP[byte & 0x0F];
-        byte = byte >> 4;
-        result += NIBBLE_LOOKUP[byte];
+        int j = graph_random(g) % (uint64_t)(i + 1);
+        int swap = permutation[i];
+        permutation[i] = permutation[j];
+        permutation[j] = swap;
     }
-    return result;
 }
 
-/* Get the index of the next set bit in
-    <adjacency_list> starting from <start_index>.
-    If the bit at <start_index> is set, <start_index>
-    is returned.
-    If no set bit is found the first <size> bytes
-    from <adjacency_list>, -1 is returned
+/* Write the row of <vertex> in the sparse representation
+    to <buffer> in ascending order and return the number
+    of entries. If <live_only> is set, neighbours that have
+    been deleted are skipped.
 */
-int get_next_bit_index(char *adjacency_list, int start_index, int size)
-{
-    int work = start_index / 8;
-    // get next not empty byte
-    while (work < size && adjacency_list[work] == 0)
-        work++;
-    // no next neighbour found
-    if (work >= size)
-        return -1;
-    for (int i = start_index % 8; i < 8; i++)
+int sparse_row(Graph g, int vertex, int *buffer, char live_only)
+{
+    struct sparse_adjacency *s = g->sparse;
+    int i = s->csr_offsets[vertex];
+    int end = s->csr_offsets[vertex + 1];
+    struct adjset *fill = &s->fill[vertex];
+    int j = 0;
+    int count = 0;
+    /* merge the imported edges with the fill-in edges */
+    while (i < end || j < fill->len)
     {
-        if (adjacency_list[work] & 1 << (7 - i))
-            return work * 8 + i;
+        int next;
+        if (j >= fill->len || (i < end && s->csr_targets[i] < fill->items[j]))
+            next = s->csr_targets[i++];
+        else
+            next = fill->items[j++];
+        if (live_only && s->deleted[next])
+            continue;
+        buffer[count++] = next;
     }
-    /* if only bits before start_index in this byte
-        are set, we have to jump to the next byte
-    */
-    work++;
-    // get next not empty byte
-    while (work < size && adjacency_list[work] == 0)
-        work++;
-    // no next neighbour found
-    if (work >= size)
-        return -1;
-    for (int i = 0; i < 8; i++)
+    return count;
+}
+
+/* return 1 if <sink> is stored in the row of <source> */
+char sparse_row_contains(Graph g, int source, int sink)
+{
+    struct sparse_adjacency *s = g->sparse;
+    int low = s->csr_offsets[source];
+    int high = s->csr_offsets[source + 1];
+    while (low < high)
     {
-        if (adjacency_list[work] & 1 << (7 - i))
-            return work * 8 + i;
+        int mid = low + (high - low) / 2;
+        if (s->csr_targets[mid] < sink)
+            low = mid + 1;
+        else
+            high = mid;
     }
-    // should not be reached
-    assert(0);
+    if (low < s->csr_offsets[source + 1] && s->csr_targets[low] == sink)
+        return 1;
+    return adjset_contains(&s->fill[source], sink);
 }
 
-/* check if a node exists and is not deleted */
-char node_invalid(Graph g, int node)
+/* get a fresh stamp for marking vertices in the sparse
+    scratch arrays */
+int sparse_next_stamp(Graph g)
 {
-    if (node < 0 ||
-        node >= g->nodes_len ||
-        g->nodes[node]->is_deleted)
-        return 1;
-    return 0;
+    struct sparse_adjacency *s = g->sparse;
+    if (s->stamp == INT_MAX)
+    {
+        memset(s->mark, 0, sizeof(int) * g->nodes_len);
+        memset(s->mark_neighbour, 0, sizeof(int) * g->nodes_len);
+        s->stamp = 0;
+    }
+    return ++s->stamp;
 }
 
-/* add node g->nodes[node_index] to the priority
+/* add node <node_index> to the priority
     lists with set number index
 */
 void priority_add_node(Graph g, int node_index, int index)
 {
     if (node_invalid(g, node_index))
         return;
+    struct Priority_t *p = g->priority;
     /*  Grow array if necessary
         This can happen if a node leads to a lot of
         fill-in edges when using that heuristic.
     */
-    while (index >= g->priority->len)
+    while (index >= p->len)
     {
-        size_t newsize = g->priority->len * 2;
-        g->priority->heads = (struct node_t **)realloc_zero(
-            g->priority->heads, sizeof(struct node_t *) * g->priority->len, sizeof(struct node_t *) * newsize);
-        g->priority->tails = (struct node_t **)realloc_zero(
-            g->priority->tails, sizeof(struct node_t *) * g->priority->len, sizeof(struct node_t *) * newsize);
-        g->priority->len = newsize;
+        size_t newsize = p->len * 2;
+        p->heads = realloc_fill(p->heads, p->len, newsize, -1);
+        p->tails = realloc_fill(p->tails, p->len, newsize, -1);
+        p->len = newsize;
     }
 
-    struct node_t *node = g->nodes[node_index];
     /* if list with index <index> is not empty */
-    if (g->priority->tails[index])
+    if (p->tails[index] >= 0)
     {
         /* link in new node*/
-        node->prev = g->priority->tails[index];
-        // assert(!g->priority->tails[index]->next);
-        g->priority->tails[index]->next = node;
-        g->priority->tails[index] = node;
+        g->prev[node_index] = p->tails[index];
+        g->next[p->tails[index]] = node_index;
+        p->tails[index] = node_index;
     }
     else
     {
         /* otherwise make this node the new head */
-        g->priority->tails[index] = g->priority->heads[index] = node;
+        p->tails[index] = p->heads[index] = node_index;
     }
 
     /* check if we have to update min and max pointers */
-    if (index > g->priority->max_ptr)
-        g->priority->max_ptr = index;
-    if (index < g->priority->min_ptr)
-        g->priority->min_ptr = index;
-    node->priority_index = index;
-    //assert(node->next != node);
+    if (index > p->max_ptr)
+        p->max_ptr = index;
+    if (index < p->min_ptr)
+        p->min_ptr = index;
+    g->priority_index[node_index] = index;
 }
 
-/* remove node g->nodes[node_index] from the
+/* remove node <node_index> from the
     priority lists
 */
 void priority_delete_node(Graph g, int node_index)
@@ -345,421 +408,1159 @@ void priority_delete_node(Graph g, int node_index)
     /* if this is the last node we won't need to do anything*/
     if(g->n <= 1) return;
 
+    struct Priority_t *p = g->priority;
+    int next = g->next[node_index];
+    int prev = g->prev[node_index];
+    int index = g->priority_index[node_index];
+
     /* unlink the node */
-    struct node_t *node = g->nodes[node_index];
-    if (node->prev)
-        node->prev->next = node->next;
+    if (prev >= 0)
+        g->next[prev] = next;
 
-    if (node->next)
-        node->next->prev = node->prev;
+    if (next >= 0)
+        g->prev[next] = prev;
 
     /*  if this node was the head, we need to set
         a new one */
-    if (node == g->priority->heads[node->priority_index])
+    if (node_index == p->heads[index])
     {
-        g->priority->heads[node->priority_index] = node->next;
+        p->heads[index] = next;
 
         /*  if this was the last node in the list
             we may need to decrease max_ptr and
             increase min_ptr
         */
-        if (!node->next)
+        if (next < 0)
         { 
-            while (g->priority->max_ptr >= 0 && !g->priority->heads[(g->priority->max_ptr)])
-                g->priority->max_ptr--;
-            while (g->priority->min_ptr < g->priority->len && !g->priority->heads[(g->priority->min_ptr)])
-                g->priority->min_ptr++;
+            while (p->max_ptr >= 0 && p->heads[p->max_ptr] < 0)
+                p->max_ptr--;
+            while (p->min_ptr < p->len && p->heads[p->min_ptr] < 0)
+                p->min_ptr++;
         }
     }
 
     /* if this was the tail we need to set a new one */
-    if (node == g->priority->tails[node->priority_index])
+    if (node_index == p->tails[index])
     {
-        g->priority->tails[node->priority_index] = node->prev;
+        p->tails[index] = prev;
 
         // max_ptr and min_ptr should have been corrected already
     }
-    node->next = node->prev = NULL;
+    g->next[node_index] = g->prev[node_index] = -1;
 }
 
-Graph graph_create(int n)
+/* add every valid vertex v to the priority list
+    <g->priority_index[v]>, in the order of the vertices.
+    Same as calling priority_add_node for each of them,
+    but the lists are only grown once */
+void priority_build(Graph g)
 {
-    Graph g = malloc(sizeof(struct graph));
-    if(!g) return NULL;
-    g->n = n;
-    g->m = 0;
-    g->nodes = malloc(sizeof(struct node_t *) * n);
-    if(!g->nodes) {
-        free(g); return NULL;}
-    g->nodes_len = n;
-    g->adjacency_matrix = malloc(sizeof(char *) * n);
-    g->ordering = malloc(sizeof(int) * n);
-    if(!g->ordering) {
-        free(g->nodes); free(g); return NULL; }
-    /* At most a node can be connected to all
-        other nodes which could be in the ordering
-        potentially, therefore n-1 is the maximum for priority */
-    g->priority = malloc(sizeof(struct Priority_t));
-    if(!g->priority) {
-        free(g->ordering); free(g->nodes); free(g); return NULL; }
-    g->priority->len = n;
-    g->priority->max_ptr = 0;
-    g->priority->min_ptr = INT_MAX;
-    g->priority->heads = malloc(sizeof(struct node_t *) * g->priority->len);
-    if(!g->priority->heads) {
-        free(g->priority); free(g->ordering); free(g->nodes); free(g); return NULL; }
-    g->priority->tails = malloc(sizeof(struct node_t *) * g->priority->len);
-    if(!g->priority->tails) {
-        free(g->priority->heads); free(g->priority); free(g->ordering); free(g->nodes); free(g); return NULL; }
-
-    // g->strategy = unspecified;
-
-    /* calculate the size of the adjacency matrix.
-        We need one more byte if the number of
-        vertices is not a multiple of 8.
-    */
-    int size = n / 8;
-    if (n % 8 != 0)
-        size++;
-    /* Resize to next multiple of alignment */
-    while (size % ALIGNMENT != 0)
+    struct Priority_t *p = g->priority;
+    /* with random ties the vertices are added in random order */
+    struct arena_mark mark = arena_get_mark(&g->scratch);
+    int *permutation = NULL;
+    if (g->random_ties)
     {
-        size++;
+        permutation = (int *)graph_scratch(g, sizeof(int) * (g->nodes_len + 1));
+        graph_random_permutation(g, permutation, g->nodes_len);
     }
-    
-    g->adjacency_size = size;
-
-    for (int i = 0; i < n; i++)
+    int max_index = -1;
+    for (int i = 0; i < g->nodes_len; i++)
     {
-        g->adjacency_matrix[i] = (char *)aligned_alloc(ALIGNMENT, size);
-        if(!g->adjacency_matrix[i]) return NULL;
-        memset(g->adjacency_matrix[i], 0, size);
-
-        g->nodes[i] = malloc(sizeof(struct node_t));
-        if(!g->nodes[i]) return NULL;
-        g->nodes[i]->id = i;
-        g->nodes[i]->degree = 0;
-        g->nodes[i]->is_deleted = 0;
-        g->nodes[i]->in_set = 0;
-        g->nodes[i]->priority_index = 0;
-        g->nodes[i]->next = NULL;
-        g->nodes[i]->prev = NULL;
-
-        g->ordering[i] = -1;
+        if (!node_invalid(g, i) && g->priority_index[i] > max_index)
+            max_index = g->priority_index[i];
     }
-
-    for (int i = 0; i < g->priority->len; i++)
+    size_t newsize = p->len;
+    while (max_index >= (int)newsize)
+        newsize *= 2;
+    if (newsize > (size_t)p->len)
     {
-        g->priority->heads[i] = NULL;
-        g->priority->tails[i] = NULL;
+        p->heads = realloc_fill(p->heads, p->len, newsize, -1);
+        p->tails = realloc_fill(p->tails, p->len, newsize, -1);
+        p->len = newsize;
     }
-
-    return g;
+    for (int k = 0; k < g->nodes_len; k++)
+    {
+        int i = permutation ? permutation[k] : k;
+        if (node_invalid(g, i))
+            continue;
+        int index = g->priority_index[i];
+        int tail = p->tails[index];
+        g->prev[i] = tail;
+        g->next[i] = -1;
+        if (tail >= 0)
+            g->next[tail] = i;
+        else
+            p->heads[index] = i;
+        p->tails[index] = i;
+        if (index > p->max_ptr)
+            p->max_ptr = index;
+        if (index < p->min_ptr)
+            p->min_ptr = index;
+    }
+    arena_reset(&g->scratch, mark);
 }
 
-Graph graph_import(FILE *fstream)
-{
+/* number of vertices at the front of a list that
+    are candidates with random ties */
+#define RANDOM_TIE_WINDOW 8
 
-    /* get the size of the graph */
-    int n;
-    char *line = NULL;
-    size_t linelen = 0;
-    Graph g = NULL;
+/* return the vertex to take from priority list <index>,
+    the first one or with random ties one of the first
+    RANDOM_TIE_WINDOW ones */
+int priority_pick(Graph g, int index)
+{
+    int pick = g->priority->heads[index];
+    if (!g->random_ties)
+        return pick;
+    int seen = 1;
+    for (int v = g->next[pick]; v >= 0 && seen < RANDOM_TIE_WINDOW; v = g->next[v])
+    {
+        seen++;
+        if (graph_random(g) % seen == 0)
+            pick = v;
+    }
+    return pick;
+}
 
-    if (fstream == NULL)
+/* allocate the scratch space and empty rows for the
+    sparse representation of a graph with n vertices whose
+    deletion flags are <deleted>, return NULL on failure */
+struct sparse_adjacency *sparse_create(int n, char *deleted)
+{
+    struct sparse_adjacency *s = malloc(sizeof(struct sparse_adjacency));
+    if (!s)
+        return NULL;
+    s->csr_offsets = calloc(n + 1, sizeof(int));
+    s->csr_targets = NULL;
+    s->shared_csr = 0;
+    s->fill = malloc(sizeof(struct adjset) * n);
+    s->deleted = deleted;
+    s->mark = calloc(n, sizeof(int));
+    s->mark_neighbour = calloc(n, sizeof(int));
+    s->stamp = 0;
+    s->list_vertex = malloc(sizeof(int) * n);
+    s->list_neighbour = malloc(sizeof(int) * n);
+    s->list_other = malloc(sizeof(int) * n);
+    if (!s->csr_offsets || !s->fill || !s->mark ||
+        !s->mark_neighbour || !s->list_vertex || !s->list_neighbour ||
+        !s->list_other)
     {
+        free(s->csr_offsets); free(s->fill); free(s->mark);
+        free(s->mark_neighbour); free(s->list_vertex); free(s->list_neighbour);
+        free(s->list_other); free(s);
         return NULL;
     }
-    /* skip over comment lines */
-    char *str;
-    do {
-        if (getline(&line, &linelen, fstream) < 0)
-        {
-            // no point in continuing if we could not read
-            free(line);
-            return NULL;
-        }
-        str = line;
-    } while (str[0] == 'c');
-
-    /* check for valid file syntax */
-    char *tok = strtok(str, " ");
-    if (tok == NULL) return NULL;
-    if (strcmp(tok, "p") != 0) return NULL;
+    for (int i = 0; i < n; i++)
+        adjset_init(&s->fill[i]);
+    return s;
+}
 
-    tok = strtok(NULL, " ");
-    if (tok == NULL)
-        return NULL;
+void sparse_destroy(struct sparse_adjacency *s, int n)
+{
+    if (!s)
+        return;
+    for (int i = 0; i < n; i++)
+        adjset_free(&s->fill[i]);
+    free(s->csr_offsets);
+    if (!s->shared_csr)
+        free(s->csr_targets);
+    free(s->fill);
+    free(s->mark);
+    free(s->mark_neighbour);
+    free(s->list_vertex);
+    free(s->list_neighbour);
+    free(s->list_other);
+    free(s);
+}
 
-    /* Decide on representation. Supported are adjacency list format ("nodes") and edge list ("edge")*/
-    if (strcmp(tok, "nodes") == 0) {
-        tok = strtok(NULL, " ");
-        if (tok == NULL)
-            return NULL;
-        // tok should now be the number of vertices as string
-        if (sscanf(tok, "%d", &n) != 1)
-        {
-            fprintf(stderr, "Conversion error\n");
-            return NULL;
-        }
+/* bytes needed for the node arrays of a graph with n vertices */
+static size_t node_block_size(int n)
+{
+    return (size_t)n * (4 * sizeof(int) + 2 * sizeof(char)) + 1;
+}
 
-        g = graph_create(n);
-        if(!g) return NULL;
+/* point the node arrays of <g> into its node block */
+static void node_block_layout(Graph g)
+{
+    int n = g->nodes_len;
+    g->degree = (int *)g->node_block;
+    g->priority_index = g->degree + n;
+    g->next = g->priority_index + n;
+    g->prev = g->next + n;
+    g->is_deleted = (char *)(g->prev + n);
+    g->in_set = g->is_deleted + n;
+}
 
-        // populate the adjacency lists of each node
-        for (int i = 0; i < g->n; i++)
-        {
-            // get the next line from file
-            if (getline(&line, &linelen, fstream) < 0)
-            {
-                // unexpected EOF etc.
-                fprintf(stderr, "Error parsing the adjacency list for node %d\n", i);
-                graph_destroy(g);
-                free(line);
-                return NULL;
-            }
-            // split line into tokens and convert to int
-            int neighbour_count = 0;
-            int node = 0;
-            char *str = line;
-            tok = strtok(str, " ");
-            // the first entry in a line is the node itself
-            if (tok != NULL)
-            {
-                if (sscanf(tok, "%d", &node) != 1)
-                {
-                    fprintf(stderr, "Conversion error\n");
-                    graph_destroy(g);
-                    return NULL;
-                }
-                //assert(node == i);
-                tok = strtok(NULL, " ");
-            }
-            while (tok != NULL)
-            {
-                if(neighbour_count > n) {
-                    fprintf(stderr, "Error importing: too many neighbours\n");
-                    graph_destroy(g);
-                    return NULL;
-                };
-                int neighbour;
-                if (sscanf(tok, "%d", &neighbour) != 1)
-                {
-                    fprintf(stderr, "Conversion error\n");
-                    graph_destroy(g);
-                    return NULL;
-                }
-                neighbour_count++;
-                graph_add_edge(g, node, neighbour);
+/* bytes of the matrix slab of a graph */
+static size_t matrix_block_size(Graph g)
+{
+    /* rows are a multiple of ALIGNMENT, so this is as well */
+    return (size_t)g->nodes_len * g->adjacency_size + ALIGNMENT;
+}
 
-                tok = strtok(NULL, " ");
-            }
-        }
-    } else if (strcmp(tok, "edge") == 0) {
-        /* get number of vertices */
-        tok = strtok(NULL, " ");
-        if (tok == NULL)
-            return NULL;
-        // tok should now be the number of vertices as string
-        if (sscanf(tok, "%d", &n) != 1)
+/* allocate everything but the edges of a graph with n vertices,
+    the arrays are not initialised. return NULL on failure */
+static Graph graph_alloc(int n, representation rep, int priority_len)
+{
+    Graph g = calloc(1, sizeof(struct graph));
+    if(!g) return NULL;
+    g->n = n;
+    g->m = 0;
+    g->nodes_len = n;
+    g->rep = rep;
+    g->node_block = malloc(node_block_size(n));
+    g->ordering = malloc(sizeof(int) * n + 1);
+    g->priority = calloc(1, sizeof(struct Priority_t));
+    if (!g->node_block || !g->ordering || !g->priority) {
+        graph_destroy(g); return NULL; }
+    node_block_layout(g);
+
+    g->priority->len = priority_len;
+    g->priority->heads = malloc(sizeof(int) * priority_len + 1);
+    g->priority->tails = malloc(sizeof(int) * priority_len + 1);
+    if (!g->priority->heads || !g->priority->tails) {
+        graph_destroy(g); return NULL; }
+
+    if (rep == sparse)
+    {
+        g->sparse = sparse_create(n, g->is_deleted);
+        if (!g->sparse) {
+            graph_destroy(g); return NULL; }
+    }
+    else
+    {
+        /* calculate the size of the adjacency matrix.
+            We need one more byte if the number of
+            vertices is not a multiple of 8.
+        */
+        int size = n / 8;
+        if (n % 8 != 0)
+            size++;
+        /* Resize to next multiple of alignment */
+        while (size % ALIGNMENT != 0)
         {
-            fprintf(stderr, "Conversion error\n");
-            return NULL;
+            size++;
         }
 
-        /* get number of edges */
-        int edges = 0;
-        tok = strtok(NULL, " ");
-        if (tok == NULL)
-            return NULL;
-        // tok should now be the number of edges as string
-        if (sscanf(tok, "%d", &edges) != 1)
-        {
-            fprintf(stderr, "Conversion error\n");
-            return NULL;
-        }
+        g->adjacency_size = size;
+        g->summary_size = bitset_summary_size(size);
+        g->adjacency_matrix = (char *)aligned_alloc(ALIGNMENT, matrix_block_size(g));
+        g->row_summary = malloc(sizeof(uint64_t) * ((size_t)n * g->summary_size + 1));
+        if (!g->adjacency_matrix || !g->row_summary) {
+            graph_destroy(g); return NULL; }
+    }
+    /* enough for a few neighbour lists and rows */
+    arena_init(&g->scratch, 4 * (sizeof(int) * n + g->adjacency_size));
+    return g;
+}
 
-        g = graph_create(n);
-        if(!g) return NULL;
-        
-        /* Try to detect if numbering starts from 0 or 1 */
-        int numbering_scheme = 1;
+/* create a graph with n vertices and no edges using
+    the representation <rep> (dense or sparse) */
+Graph graph_create_representation(int n, representation rep)
+{
+    /* At most a node can be connected to all
+        other nodes which could be in the ordering
+        potentially, therefore n-1 is the maximum for priority */
+    Graph g = graph_alloc(n, rep, n);
+    if(!g) return NULL;
 
-        // read in the edges
-        for (int i = 0; i < edges; i++)
-        {
-            // get the next line from file
-            if (getline(&line, &linelen, fstream) < 0)
-            {
-                // unexpected EOF etc.
-                fprintf(stderr, "Error the %d`st edge entry\n", i);
-                graph_destroy(g);
-                free(line);
-                return NULL;
-            }
-            // skip comments and empty lines
-            if (line[0] == 'c' || line[0] == '\r' || line[0] == '\n')
-            {
-                i--;
-                continue;
-            }
-            
-            str = line;
-            tok = strtok(str, " ");
-            if (tok == NULL) return NULL;
-            if (strcmp(tok, "e") != 0) return NULL;
-            // split line into tokens and convert to int
-            // the first entry in a line is the sink
-            int source;
-            tok = strtok(NULL, " ");
-            if (tok == NULL) return NULL;
-            if (sscanf(tok, "%d", &source) != 1)
-            {
-                fprintf(stderr, "Conversion error\n");
-                graph_destroy(g);
-                return NULL;
-            }
-            if (source == 0 && numbering_scheme > 0)
-            {
-                if (i == 0) numbering_scheme = 0;
-                else {
-                    fprintf(stderr, "Found 0 numbering scheme too late (entry %d).\n"
-                     "Make sure the first edge entry has source 0 if you number from 0\n", i);
-                    return NULL;
-                }
-            }
-            
-            // the second one is the sink
-            int sink;
-            tok = strtok(NULL, " ");
-            if (tok == NULL) return NULL;
-            if (sscanf(tok, "%d", &sink) != 1)
-            {
-                fprintf(stderr, "Conversion error\n");
-                graph_destroy(g);
-                return NULL;
-            }
-            /* It seems people like to count from 1 */
-            graph_add_edge(g, source-numbering_scheme, sink-numbering_scheme);
-        }
+    if (rep != sparse)
+    {
+        memset(g->adjacency_matrix, 0, matrix_block_size(g));
+        memset(g->row_summary, 0, sizeof(uint64_t) * ((size_t)n * g->summary_size + 1));
     }
-    // fprintf(stdout, "Number of vertices: %d\n", n);
+    memset(g->degree, 0, sizeof(int) * n);
+    memset(g->priority_index, 0, sizeof(int) * n);
+    memset(g->next, -1, sizeof(int) * n);
+    memset(g->prev, -1, sizeof(int) * n);
+    memset(g->is_deleted, 0, n);
+    memset(g->in_set, 0, n);
+    memset(g->ordering, -1, sizeof(int) * n);
+
+    g->priority->max_ptr = 0;
+    g->priority->min_ptr = INT_MAX;
+    memset(g->priority->heads, -1, sizeof(int) * g->priority->len);
+    memset(g->priority->tails, -1, sizeof(int) * g->priority->len);
 
-    free(line);
     return g;
 }
 
-Graph graph_copy(Graph g)
+Graph graph_create(int n)
 {
-    if(!g) return NULL;
-    if(!g->nodes) return NULL;
+    return graph_create_representation(n, dense);
+}
 
-    Graph copy = malloc(sizeof(struct graph));
-    if(!copy) return NULL;
-    int n = g->nodes_len;
-    copy->n = g->n;
-    copy->m = g->m;
-    copy->nodes = malloc(sizeof(struct node_t *) * n);
-    if(!copy->nodes) return NULL;
-    copy->nodes_len = g->nodes_len;
-    copy->adjacency_matrix = malloc(sizeof(char *) * g->n);
-    copy->adjacency_size = g->adjacency_size;
-    copy->ordering = malloc(sizeof(int) * n);
-    if(!copy->ordering) return NULL;
-
-    copy->priority = malloc(sizeof(struct Priority_t));
-    if(!copy->priority) return NULL;
-    copy->priority->len = g->priority->len;
-    copy->priority->max_ptr = g->priority->max_ptr;
-    copy->priority->min_ptr = g->priority->min_ptr;
-    copy->priority->heads = malloc(sizeof(struct node_t *) * g->priority->len);
-    if(!copy->priority->heads) return NULL;
-    copy->priority->tails = malloc(sizeof(struct node_t *) * g->priority->len);
-    if(!copy->priority->tails) return NULL;
+representation graph_representation(Graph g)
+{
+    return g->rep;
+}
 
-    // copy->strategy = g->strategy;
+int compare_int(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
 
-    for (int i = 0; i < n; i++)
+/* pick a representation for a graph with n vertices and m edges */
+representation choose_representation(int n, size_t m)
+{
+    size_t row = n / 8 + 1;
+    if (row * n <= DENSE_MAX_BYTES)
+        return dense;
+    /* A sparse row needs an int per neighbour, leave room
+        for the same amount of fill-in. Above that the bit
+        matrix is the more compact representation anyway. */
+    if (n > 0 && 2 * m / n * sizeof(int) * 2 >= row)
+        return dense;
+    return sparse;
+}
+
+/*  The import parses the file in memory: regular files are
+    mapped, anything else (pipes) is read into a buffer first.
+    The edges are scanned twice, the first pass counts the
+    entries of every row, so the second one can write them
+    straight to storage of the exact size.
+*/
+struct import_source
+{
+    const char *data;
+    size_t len;
+    void *map;    /* the mapping, NULL if <data> was read */
+    size_t map_len;
+};
+
+/* make the rest of <fstream> available as one buffer,
+    return 1 on success, 0 otherwise */
+char import_source_open(struct import_source *src, FILE *fstream)
+{
+    src->map = NULL;
+    src->data = NULL;
+    src->len = 0;
+    struct stat info;
+    off_t start = ftello(fstream);
+    if (start >= 0 && fstat(fileno(fstream), &info) == 0 &&
+        S_ISREG(info.st_mode) && info.st_size > start)
     {
-        copy->adjacency_matrix[i] = (char *)aligned_alloc(ALIGNMENT, copy->adjacency_size);
-        if(!copy->adjacency_matrix[i]) return NULL;
-        memcpy(copy->adjacency_matrix[i], g->adjacency_matrix[i], copy->adjacency_size);
-
-        copy->nodes[i] = malloc(sizeof(struct node_t));
-        if(!copy->nodes[i]) return NULL;
-        copy->nodes[i]->id = g->nodes[i]->id;
-        copy->nodes[i]->degree = g->nodes[i]->degree;
-        copy->nodes[i]->is_deleted = g->nodes[i]->is_deleted;
-        copy->nodes[i]->in_set = g->nodes[i]->in_set;
-        copy->nodes[i]->priority_index = g->nodes[i]->priority_index;
-
-        /* If the original has next/prev link to the node
-            with the same id in the copy, otherwise
-            to NULL pointer
-        */
-        if (g->nodes[i]->next)
-        {
-            copy->nodes[i]->next = copy->nodes[g->nodes[i]->next->id];
-        }
-        else
-            copy->nodes[i]->next = NULL;
-        if (g->nodes[i]->prev)
+        void *map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fileno(fstream), 0);
+        if (map != MAP_FAILED)
         {
-            copy->nodes[i]->prev = copy->nodes[g->nodes[i]->prev->id];
+            madvise(map, info.st_size, MADV_SEQUENTIAL);
+            src->map = map;
+            src->map_len = info.st_size;
+            src->data = (const char *)map + start;
+            src->len = info.st_size - start;
+            return 1;
         }
-        else
-            copy->nodes[i]->prev = NULL;
-        copy->ordering[i] = g->ordering[i];
     }
-
-    /* Link to new heads and tails if they were present in original*/
-    for (int i = 0; i < g->priority->len; i++)
+    /* not mappable, read it */
+    size_t cap = 1 << 16;
+    char *buffer = malloc(cap);
+    size_t got;
+    while (buffer && (got = fread(buffer + src->len, 1, cap - src->len, fstream)) > 0)
     {
-        if (g->priority->heads[i])
-        {
-            copy->priority->heads[i] = copy->nodes[g->priority->heads[i]->id];
-        }
-        else
-            copy->priority->heads[i] = NULL;
-        if (g->priority->tails[i])
+        src->len += got;
+        if (src->len == cap)
         {
-            copy->priority->tails[i] = copy->nodes[g->priority->tails[i]->id];
+            char *grown = realloc(buffer, cap * 2);
+            if (!grown)
+            {
+                free(buffer);
+                buffer = NULL;
+                break;
+            }
+            buffer = grown;
+            cap *= 2;
         }
-        else
-            copy->priority->tails[i] = NULL;
     }
+    if (!buffer || ferror(fstream))
+    {
+        free(buffer);
+        return 0;
+    }
+    src->data = buffer;
+    return 1;
+}
 
-    return copy;
+void import_source_close(struct import_source *src)
+{
+    if (src->map)
+        munmap(src->map, src->map_len);
+    else
+        free((char *)src->data);
 }
 
-void graph_destroy(Graph g)
+/* skip spaces, tabs and carriage returns */
+static inline const char *skip_blanks(const char *p, const char *end)
 {
-    if(!g) return;
-    int i;
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+    return p;
+}
 
-    for (i = 0; i < g->nodes_len; i++)
+/* return the start of the line after the one <p> is in */
+static inline const char *next_line(const char *p, const char *end)
+{
+    const char *newline = memchr(p, '\n', end - p);
+    return newline ? newline + 1 : end;
+}
+
+/* read a decimal integer at <*p> after skipping blanks and
+    advance <*p> behind it.
+    return 1 on success, 0 if there is no number or it does not fit */
+static inline char scan_int(const char **p, const char *end, int *value)
+{
+    const char *s = skip_blanks(*p, end);
+    char negative = 0;
+    if (s < end && *s == '-')
+    {
+        negative = 1;
+        s++;
+    }
+    if (s == end || (unsigned)(*s - '0') > 9)
+        return 0;
+    long long v = 0;
+    while (s < end && (unsigned)(*s - '0') <= 9)
+    {
+        v = v * 10 + (*s++ - '0');
+        if (v > INT_MAX)
+            return 0;
+    }
+    /* the number has to end at a separator */
+    if (s < end && *s != ' ' && *s != '\t' && *s != '\r' && *s != '\n')
+        return 0;
+    *value = negative ? (int)-v : (int)v;
+    *p = s;
+    return 1;
+}
+
+/* compare the word at <*p> (after blanks) with <word>
+    and advance behind it if it matches */
+static inline char scan_word(const char **p, const char *end, const char *word)
+{
+    const char *s = skip_blanks(*p, end);
+    size_t len = strlen(word);
+    if ((size_t)(end - s) < len || memcmp(s, word, len) != 0)
+        return 0;
+    s += len;
+    if (s < end && *s != ' ' && *s != '\t' && *s != '\r' && *s != '\n')
+        return 0;
+    *p = s;
+    return 1;
+}
+
+/* one pass over the edges of an imported file */
+struct import_pass
+{
+    Graph g;      /* NULL in the counting pass */
+    int *count;   /* counting pass: row sizes, entry v+1 for row v */
+    int *pos;     /* sparse graphs: next free entry of each csr row */
+    int numbering; /* number of the first vertex in the file */
+};
+
+static inline void import_edge(struct import_pass *pass, int u, int v)
+{
+    /* self loops do not matter for tree decompositions */
+    if (u == v)
+        return;
+    if (!pass->g)
+    {
+        pass->count[u + 1]++;
+        pass->count[v + 1]++;
+    }
+    else if (pass->g->rep == sparse)
+    {
+        int *targets = pass->g->sparse->csr_targets;
+        targets[pass->pos[u]++] = v;
+        targets[pass->pos[v]++] = u;
+    }
+    else
+        graph_add_edge(pass->g, u, v);
+}
+
+/* Scan the adjacency lists ("p nodes" format) starting at <p>,
+    every line lists a vertex followed by its neighbours.
+    return 1 on success, 0 otherwise */
+char import_scan_nodes(const char *p, const char *end, int n, struct import_pass *pass)
+{
+    for (int i = 0; i < n; i++)
+    {
+        if (p >= end)
+        {
+            // unexpected EOF etc.
+            fprintf(stderr, "Error parsing the adjacency list for node %d\n", i);
+            return 0;
+        }
+        const char *line_end = next_line(p, end);
+        // the first entry in a line is the node itself
+        int node;
+        const char *first = skip_blanks(p, line_end);
+        if (first == line_end || *first == '\n')
+        {
+            p = line_end;
+            continue;
+        }
+        if (!scan_int(&p, line_end, &node))
+        {
+            fprintf(stderr, "Conversion error\n");
+            return 0;
+        }
+        int neighbour_count = 0;
+        for (;;)
+        {
+            p = skip_blanks(p, line_end);
+            if (p == line_end || *p == '\n')
+                break;
+            if (neighbour_count > n)
+            {
+                fprintf(stderr, "Error importing: too many neighbours\n");
+                return 0;
+            }
+            int neighbour;
+            if (!scan_int(&p, line_end, &neighbour))
+            {
+                fprintf(stderr, "Conversion error\n");
+                return 0;
+            }
+            if (node < 0 || node >= n || neighbour < 0 || neighbour >= n)
+            {
+                fprintf(stderr, "Error importing: vertex out of range\n");
+                return 0;
+            }
+            neighbour_count++;
+            import_edge(pass, node, neighbour);
+        }
+        p = line_end;
+    }
+    return 1;
+}
+
+/* Scan <edge_count> edge lines ("e source sink", DIMACS format)
+    starting at <p>. Vertices are numbered from 1 unless the first
+    edge has source 0.
+    return 1 on success, 0 otherwise */
+char import_scan_edges(const char *p, const char *end, int n, int edge_count, struct import_pass *pass)
+{
+    /* Try to detect if numbering starts from 0 or 1 */
+    int numbering_scheme = 1;
+
+    for (int i = 0; i < edge_count; i++)
+    {
+        if (p >= end)
+        {
+            // unexpected EOF etc.
+            fprintf(stderr, "Error the %d`st edge entry\n", i);
+            return 0;
+        }
+        const char *line_end = next_line(p, end);
+        // skip comments and empty lines
+        if (*p == 'c' || *p == '\r' || *p == '\n')
+        {
+            p = line_end;
+            i--;
+            continue;
+        }
+        int source, sink;
+        if (!scan_word(&p, line_end, "e"))
+            return 0;
+        // the first entry in a line is the source, the second one the sink
+        if (!scan_int(&p, line_end, &source) || !scan_int(&p, line_end, &sink))
+        {
+            fprintf(stderr, "Conversion error\n");
+            return 0;
+        }
+        if (source == 0 && numbering_scheme > 0)
+        {
+            if (i == 0) numbering_scheme = 0;
+            else {
+                fprintf(stderr, "Found 0 numbering scheme too late (entry %d).\n"
+                 "Make sure the first edge entry has source 0 if you number from 0\n", i);
+                return 0;
+            }
+        }
+        /* It seems people like to count from 1 */
+        source -= numbering_scheme;
+        sink -= numbering_scheme;
+        if (source < 0 || source >= n || sink < 0 || sink >= n)
+        {
+            fprintf(stderr, "Error importing: vertex out of range in edge entry %d\n", i);
+            return 0;
+        }
+        import_edge(pass, source, sink);
+        p = line_end;
+    }
+    pass->numbering = numbering_scheme;
+    return 1;
+}
+
+/* Sort the csr rows of a sparse graph filled by the import
+    and compact them to remove duplicate edges. */
+void sparse_finish_csr(Graph g)
+{
+    struct sparse_adjacency *s = g->sparse;
+    int n = g->nodes_len;
+    int write = 0;
+    int start = 0;
+    for (int i = 0; i < n; i++)
+    {
+        int end = s->csr_offsets[i + 1];
+        qsort(s->csr_targets + start, end - start, sizeof(int), compare_int);
+        s->csr_offsets[i] = write;
+        for (int j = start; j < end; j++)
+        {
+            if (j > start && s->csr_targets[j] == s->csr_targets[j - 1])
+                continue;
+            s->csr_targets[write++] = s->csr_targets[j];
+        }
+        g->degree[i] = write - s->csr_offsets[i];
+        g->m += g->degree[i];
+        start = end;
+    }
+    s->csr_offsets[n] = write;
+    g->m /= 2;
+}
+
+/*  Binary graph files (.tdbin): a header followed by the
+    compressed sparse rows of the graph, n + 1 offsets and
+    then the neighbours of each vertex in ascending order,
+    all as 32 bit integers in the byte order of the machine
+    that wrote the file. Loading them needs no parsing.
+*/
+#define TDBIN_MAGIC "TDBIN\n\032"
+#define TDBIN_VERSION 1
+#define TDBIN_BYTE_ORDER 0x01020304u
+
+struct tdbin_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t n;
+    uint32_t numbering;       /* number of the first vertex in the source file */
+    uint64_t m;
+    uint64_t entries;         /* number of neighbour entries, 2 * m */
+    uint64_t checksum;        /* of the offsets and neighbours */
+    /* the text file a cached graph was converted from, 0 otherwise */
+    int64_t source_mtime_sec;
+    int64_t source_mtime_nsec;
+    uint64_t source_size;
+};
+
+/* continue the checksum <hash> with <count> words */
+uint64_t tdbin_checksum(uint64_t hash, const uint32_t *words, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        hash = (hash ^ words[i]) * 0x100000001b3ULL;
+    return hash;
+}
+
+#define TDBIN_CHECKSUM_START 0xcbf29ce484222325ULL
+
+/* import the graph from the binary file contents <data> */
+Graph graph_import_binary(const char *data, size_t len, representation rep)
+{
+    struct tdbin_header h;
+    if (len < sizeof(h))
+    {
+        fprintf(stderr, "Error importing: truncated binary graph header\n");
+        return NULL;
+    }
+    memcpy(&h, data, sizeof(h));
+    if (h.version != TDBIN_VERSION || h.byte_order != TDBIN_BYTE_ORDER)
+    {
+        fprintf(stderr, "Error importing: unsupported binary graph version or byte order\n");
+        return NULL;
+    }
+    if (h.n > INT_MAX || h.entries > INT_MAX || h.entries != 2 * h.m)
+    {
+        fprintf(stderr, "Error importing: invalid vertex or edge count in binary graph\n");
+        return NULL;
+    }
+    if (len < sizeof(h) + sizeof(uint32_t) * (h.n + 1 + h.entries))
+    {
+        fprintf(stderr, "Error importing: truncated binary graph\n");
+        return NULL;
+    }
+    if ((uintptr_t)(data + sizeof(h)) % sizeof(uint32_t))
+    {
+        fprintf(stderr, "Error importing: misaligned binary graph data\n");
+        return NULL;
+    }
+    int n = h.n;
+    const uint32_t *offsets = (const uint32_t *)(data + sizeof(h));
+    const uint32_t *targets = offsets + n + 1;
+    if (tdbin_checksum(TDBIN_CHECKSUM_START, offsets, n + 1 + h.entries) != h.checksum)
+    {
+        fprintf(stderr, "Error importing: checksum mismatch in binary graph\n");
+        return NULL;
+    }
+    /* the rest of the code relies on sorted, symmetric rows without
+        self loops */
+    if (offsets[0] != 0 || offsets[n] != h.entries)
+    {
+        fprintf(stderr, "Error importing: offsets of binary graph do not span its neighbours\n");
+        return NULL;
+    }
+    for (int u = 0; u < n; u++)
+    {
+        if (offsets[u + 1] < offsets[u] || offsets[u + 1] > h.entries)
+        {
+            fprintf(stderr, "Error importing: offsets of row %d in binary graph out of order\n", u);
+            return NULL;
+        }
+        for (uint32_t j = offsets[u]; j < offsets[u + 1]; j++)
+        {
+            if (targets[j] >= (uint32_t)n || targets[j] == (uint32_t)u ||
+                (j > offsets[u] && targets[j] <= targets[j - 1]))
+            {
+                fprintf(stderr, "Error importing: invalid row %d in binary graph\n", u);
+                return NULL;
+            }
+        }
+    }
+    /* Symmetry in one pass over the sorted rows: the smaller
+        neighbours of v are, in ascending order, exactly the rows u < v
+        holding v, so every such entry has to match the next unmatched
+        one of row v, and no smaller neighbour may be left over. */
+    uint32_t *unmatched = (uint32_t *)malloc(sizeof(uint32_t) * (n + 1));
+    if (!unmatched)
+        return NULL;
+    memcpy(unmatched, offsets, sizeof(uint32_t) * n);
+    for (int u = 0; u < n; u++)
+    {
+        for (uint32_t j = offsets[u]; j < offsets[u + 1]; j++)
+        {
+            uint32_t v = targets[j];
+            if (v < (uint32_t)u)
+                continue;
+            if (unmatched[v] == offsets[v + 1] || targets[unmatched[v]] != (uint32_t)u)
+            {
+                fprintf(stderr, "Error importing: edge %d %u of binary graph is missing in row %u\n", u, v, v);
+                free(unmatched);
+                return NULL;
+            }
+            unmatched[v]++;
+        }
+    }
+    for (int v = 0; v < n; v++)
+    {
+        if (unmatched[v] < offsets[v + 1] && targets[unmatched[v]] < (uint32_t)v)
+        {
+            fprintf(stderr, "Error importing: edge %d %u of binary graph is missing in row %u\n",
+                    v, targets[unmatched[v]], targets[unmatched[v]]);
+            free(unmatched);
+            return NULL;
+        }
+    }
+    free(unmatched);
+
+    if (rep == automatic)
+        rep = choose_representation(n, h.m);
+    Graph g = graph_create_representation(n, rep);
+    if (!g)
+        return NULL;
+    g->numbering = h.numbering;
+    g->m = h.m;
+    for (int u = 0; u < n; u++)
+        g->degree[u] = offsets[u + 1] - offsets[u];
+    if (rep == sparse)
+    {
+        struct sparse_adjacency *s = g->sparse;
+        s->csr_targets = malloc(sizeof(int) * (h.entries > 0 ? h.entries : 1));
+        if (!s->csr_targets)
+        {
+            graph_destroy(g);
+            return NULL;
+        }
+        memcpy(s->csr_offsets, offsets, sizeof(int) * (n + 1));
+        memcpy(s->csr_targets, targets, sizeof(int) * h.entries);
+    }
+    else
+    {
+        for (int u = 0; u < n; u++)
+            for (uint32_t j = offsets[u]; j < offsets[u + 1]; j++)
+                matrix_set(g, u, targets[j]);
+    }
+    return g;
+}
+
+/* the kinds of files graph_import understands */
+enum import_format { format_nodes, format_edge };
+
+/* run a pass of the scanner for <format> */
+char import_scan(enum import_format format, const char *p, const char *end,
+                 int n, int edge_count, struct import_pass *pass)
+{
+    if (format == format_nodes)
+        return import_scan_nodes(p, end, n, pass);
+    return import_scan_edges(p, end, n, edge_count, pass);
+}
+
+/* import the graph from the file contents in <src> */
+Graph graph_import_source(struct import_source *src, representation rep)
+{
+    const char *p = src->data, *end = src->data + src->len;
+    int n, edge_count = 0;
+    enum import_format format;
+
+    if (src->len >= 8 && memcmp(p, TDBIN_MAGIC, 8) == 0)
+        return graph_import_binary(p, src->len, rep);
+
+    /* skip over comment lines */
+    while (p < end && *p == 'c')
+        p = next_line(p, end);
+    /* check for valid file syntax */
+    if (p >= end || !scan_word(&p, end, "p"))
+        return NULL;
+    /* Decide on representation. Supported are adjacency list format ("nodes") and edge list ("edge")*/
+    if (scan_word(&p, end, "nodes"))
+        format = format_nodes;
+    else if (scan_word(&p, end, "edge"))
+        format = format_edge;
+    else
+        return NULL;
+    // the number of vertices, for edge lists followed by the number of edges
+    if (!scan_int(&p, end, &n) || n < 0 ||
+        (format == format_edge && !scan_int(&p, end, &edge_count)))
+    {
+        fprintf(stderr, "Conversion error\n");
+        return NULL;
+    }
+    p = next_line(p, end);
+
+    /* first pass: count the entries of every row */
+    struct import_pass pass = {NULL, calloc(n + 1, sizeof(int)), NULL, 0};
+    if (!pass.count)
+        return NULL;
+    if (!import_scan(format, p, end, n, edge_count, &pass))
+    {
+        free(pass.count);
+        return NULL;
+    }
+    for (int i = 0; i < n; i++)
+        pass.count[i + 1] += pass.count[i];
+    size_t entries = pass.count[n];
+
+    if (rep == automatic)
+        rep = choose_representation(n, entries / 2);
+    Graph g = graph_create_representation(n, rep);
+    if (!g)
+    {
+        free(pass.count);
+        return NULL;
+    }
+    if (rep == sparse)
+    {
+        struct sparse_adjacency *s = g->sparse;
+        memcpy(s->csr_offsets, pass.count, sizeof(int) * (n + 1));
+        s->csr_targets = malloc(sizeof(int) * (entries > 0 ? entries : 1));
+        if (!s->csr_targets)
+        {
+            free(pass.count);
+            graph_destroy(g);
+            return NULL;
+        }
+        /* use the list buffer as insert position of every row */
+        pass.pos = s->list_vertex;
+        memcpy(pass.pos, s->csr_offsets, sizeof(int) * n);
+    }
+    free(pass.count);
+    pass.count = NULL;
+
+    /* second pass: store the edges, the input was checked already */
+    pass.g = g;
+    import_scan(format, p, end, n, edge_count, &pass);
+    g->numbering = pass.numbering;
+    if (rep == sparse)
+        sparse_finish_csr(g);
+    return g;
+}
+
+Graph graph_import(FILE *fstream)
+{
+    return graph_import_as(fstream, automatic);
+}
+
+Graph graph_import_as(FILE *fstream, representation rep)
+{
+    if (fstream == NULL)
+    {
+        return NULL;
+    }
+    struct import_source src;
+    if (!import_source_open(&src, fstream))
+        return NULL;
+    Graph g = graph_import_source(&src, rep);
+    import_source_close(&src);
+    return g;
+}
+
+/* write g in binary format, with <source> describing the file
+    it was converted from (NULL if none).
+    return 1 on success, 0 otherwise */
+char graph_write_binary(Graph g, FILE *fstream, const struct stat *source)
+{
+    /* deleted vertices would leave holes in the numbering */
+    if (g->n != g->nodes_len)
+        return 0;
+    int n = g->nodes_len;
+    struct tdbin_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, TDBIN_MAGIC, sizeof(h.magic));
+    h.version = TDBIN_VERSION;
+    h.byte_order = TDBIN_BYTE_ORDER;
+    h.n = n;
+    h.numbering = g->numbering;
+    h.m = g->m;
+    h.entries = 2 * (uint64_t)g->m;
+    if (source)
+    {
+        h.source_mtime_sec = source->st_mtim.tv_sec;
+        h.source_mtime_nsec = source->st_mtim.tv_nsec;
+        h.source_size = source->st_size;
+    }
+    /* the checksum is only known at the end, the header
+        is written again then */
+    if (fwrite(&h, sizeof(h), 1, fstream) != 1)
+        return 0;
+
+    struct arena_mark mark = arena_get_mark(&g->scratch);
+    uint32_t *offsets = graph_scratch(g, sizeof(uint32_t) * (n + 1));
+    offsets[0] = 0;
+    for (int u = 0; u < n; u++)
+        offsets[u + 1] = offsets[u] + g->degree[u];
+    uint64_t hash = tdbin_checksum(TDBIN_CHECKSUM_START, offsets, n + 1);
+    char ok = fwrite(offsets, sizeof(uint32_t), n + 1, fstream) == (size_t)n + 1;
+    int *row = graph_scratch(g, sizeof(int) * (n > 0 ? n : 1));
+    for (int u = 0; ok && u < n; u++)
+    {
+        int len = graph_neighbours(g, u, row);
+        hash = tdbin_checksum(hash, (const uint32_t *)row, len);
+        ok = fwrite(row, sizeof(int), len, fstream) == (size_t)len;
+    }
+    arena_reset(&g->scratch, mark);
+    if (!ok)
+        return 0;
+
+    h.checksum = hash;
+    if (fseek(fstream, -(long)(sizeof(h) + sizeof(uint32_t) * (n + 1 + h.entries)), SEEK_CUR) != 0 ||
+        fwrite(&h, sizeof(h), 1, fstream) != 1 ||
+        fseek(fstream, 0, SEEK_END) != 0)
+        return 0;
+    return fflush(fstream) == 0;
+}
+
+char graph_export_binary(Graph g, FILE *fstream)
+{
+    return graph_write_binary(g, fstream, NULL);
+}
+
+/* return 1 if the file <path> starts with a binary graph header,
+    if <header> is not NULL the header is copied there */
+char binary_file_header(const char *path, struct tdbin_header *header)
+{
+    struct tdbin_header h;
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return 0;
+    char found = fread(&h, sizeof(h), 1, f) == 1 &&
+                 memcmp(h.magic, TDBIN_MAGIC, sizeof(h.magic)) == 0;
+    fclose(f);
+    if (found && header)
+        *header = h;
+    return found;
+}
+
+/* import the graph of the file <path>, return NULL on failure */
+Graph import_file(const char *path, representation rep)
+{
+    FILE *fstream = fopen(path, "r");
+    if (!fstream)
     {
-        free(g->nodes[i]);
-        free(g->adjacency_matrix[i]);
+        fprintf(stderr, "Error opening file %s: %s\n", path, strerror(errno));
+        return NULL;
     }
+    Graph g = graph_import_as(fstream, rep);
+    fclose(fstream);
+    return g;
+}
+
+/* store g as cache of the text file <path>, the file is written
+    under a temporary name first so concurrent imports never see
+    a partial cache */
+void cache_store(Graph g, const char *path, const char *cache_path, const struct stat *source)
+{
+    size_t len = strlen(cache_path);
+    char *temp = malloc(len + 8);
+    if (!temp)
+        return;
+    snprintf(temp, len + 8, "%s.XXXXXX", cache_path);
+    int fd = mkstemp(temp);
+    FILE *fstream = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    char ok = fstream && graph_write_binary(g, fstream, source);
+    if (fstream)
+        ok = fclose(fstream) == 0 && ok;
+    else if (fd >= 0)
+        close(fd);
+    if (ok)
+        ok = rename(temp, cache_path) == 0;
+    if (!ok)
+    {
+        if (fd >= 0)
+            unlink(temp);
+        fprintf(stderr, "Warning: could not write cache file for %s\n", path);
+    }
+    free(temp);
+}
+
+Graph graph_import_path(const char *path, representation rep, char cache)
+{
+    struct stat source;
+    if (!cache || stat(path, &source) != 0 || !S_ISREG(source.st_mode) ||
+        binary_file_header(path, NULL))
+        return import_file(path, rep);
+
+    size_t len = strlen(path);
+    char *cache_path = malloc(len + sizeof(TDBIN_EXTENSION));
+    if (!cache_path)
+        return NULL;
+    memcpy(cache_path, path, len);
+    memcpy(cache_path + len, TDBIN_EXTENSION, sizeof(TDBIN_EXTENSION));
+
+    /* use the cache if it was made from the file as it is now */
+    Graph g = NULL;
+    struct tdbin_header h;
+    if (binary_file_header(cache_path, &h) &&
+        h.source_mtime_sec == source.st_mtim.tv_sec &&
+        h.source_mtime_nsec == source.st_mtim.tv_nsec &&
+        h.source_size == (uint64_t)source.st_size)
+        g = import_file(cache_path, rep);
+    if (!g)
+    {
+        g = import_file(path, rep);
+        if (g)
+            cache_store(g, path, cache_path, &source);
+    }
+    free(cache_path);
+    return g;
+}
+
+/* graph_copy and graph_clone, the imported edges of the
+    sparse representation are shared if <share> is 1 */
+static Graph graph_copy_sharing(Graph g, char share)
+{
+    if(!g) return NULL;
+
+    int n = g->nodes_len;
+    Graph copy = graph_alloc(n, g->rep, g->priority->len);
+    if(!copy) return NULL;
+    copy->n = g->n;
+    copy->m = g->m;
+    copy->numbering = g->numbering;
+
+    /* the node arrays use vertex ids for the links, so
+        everything can be copied as it is */
+    memcpy(copy->node_block, g->node_block, node_block_size(n));
+    memcpy(copy->ordering, g->ordering, sizeof(int) * n);
+    copy->priority->max_ptr = g->priority->max_ptr;
+    copy->priority->min_ptr = g->priority->min_ptr;
+    memcpy(copy->priority->heads, g->priority->heads, sizeof(int) * g->priority->len);
+    memcpy(copy->priority->tails, g->priority->tails, sizeof(int) * g->priority->len);
+
+    // copy->strategy = g->strategy;
+
+    if (g->rep == sparse)
+    {
+        int entries = g->sparse->csr_offsets[n];
+        memcpy(copy->sparse->csr_offsets, g->sparse->csr_offsets, sizeof(int) * (n + 1));
+        if (share)
+        {
+            copy->sparse->csr_targets = g->sparse->csr_targets;
+            copy->sparse->shared_csr = 1;
+        }
+        else
+        {
+            copy->sparse->csr_targets = malloc(sizeof(int) * (entries > 0 ? entries : 1));
+            if(!copy->sparse->csr_targets) {
+                graph_destroy(copy); return NULL; }
+            memcpy(copy->sparse->csr_targets, g->sparse->csr_targets, sizeof(int) * entries);
+        }
+        for (int i = 0; i < n; i++)
+        {
+            if(!adjset_copy(&copy->sparse->fill[i], &g->sparse->fill[i])) {
+                graph_destroy(copy); return NULL; }
+        }
+    }
+    else
+    {
+        memcpy(copy->adjacency_matrix, g->adjacency_matrix, matrix_block_size(g));
+        memcpy(copy->row_summary, g->row_summary,
+               sizeof(uint64_t) * ((size_t)n * g->summary_size + 1));
+    }
+
+    return copy;
+}
+
+Graph graph_copy(Graph g)
+{
+    return graph_copy_sharing(g, 0);
+}
+
+Graph graph_clone(Graph g)
+{
+    return graph_copy_sharing(g, 1);
+}
+
+void graph_destroy(Graph g)
+{
+    if(!g) return;
+    if (g->elimination != g)
+        graph_destroy(g->elimination);
     free(g->adjacency_matrix);
-    free(g->nodes);
+    free(g->row_summary);
+    arena_free(&g->scratch);
+    sparse_destroy(g->sparse, g->nodes_len);
+    free(g->node_block);
     free(g->ordering);
-    free(g->priority->heads);
-    free(g->priority->tails);
-    free(g->priority);
+    if (g->priority)
+    {
+        free(g->priority->heads);
+        free(g->priority->tails);
+        free(g->priority);
+    }
     free(g);
 }
 
+/* remember <elimination> as the eliminated graph of the
+    ordering of g, replacing an earlier one */
+void graph_set_elimination(Graph g, Graph elimination)
+{
+    if (g->elimination != g && g->elimination != elimination)
+        graph_destroy(g->elimination);
+    g->elimination = elimination;
+}
+
 void graph_add_edge(Graph g, int u, int v)
 {
     if (graph_has_edge(g, u, v))
         return;
 
-    g->adjacency_matrix[u][v / 8] |= 1 << (7 - v % 8);
-    g->nodes[u]->degree++;
-    g->adjacency_matrix[v][u / 8] |= 1 << (7 - u % 8);
-    g->nodes[v]->degree++;
+    if (g->rep == sparse)
+    {
+        if (adjset_insert(&g->sparse->fill[u], v) < 0 ||
+            adjset_insert(&g->sparse->fill[v], u) < 0)
+        {
+            fprintf(stderr, "Out of memory adding edge %d - %d\n", u, v);
+            abort();
+        }
+    }
+    else
+    {
+        matrix_set(g, u, v);
+        matrix_set(g, v, u);
+    }
+    g->degree[u]++;
+    g->degree[v]++;
 
     /* bump edge count */
     g->m++;
@@ -770,14 +1571,72 @@ void graph_add_edge(Graph g, int u, int v)
      and write the result to <buffer>. The caller is responsible for
     sizing the buffer correctly! (degree of vertex) */
 int convert_bit_field_to_list(char* pointer, int size, int *buffer) {
-    int neighbour = -1;
-    int i = 0;
-    while ((neighbour = get_next_bit_index(pointer, neighbour+1, size)) >=0 )
+    return bitset_to_list(pointer, size, buffer);
+}
+
+/* convert_bit_field_to_list for the matrix row of <vertex>,
+    skipping empty words with the help of its summary */
+int matrix_row_to_list(Graph g, int vertex, int *buffer)
+{
+    return bitset_to_list_summary(matrix_row(g, vertex), row_summary(g, vertex),
+                                  g->adjacency_size, buffer);
+}
+
+/* Write the neighbours of <vertex> to <buffer> in ascending
+    order and return their number. The caller is responsible
+    for sizing the buffer correctly! (degree of vertex) */
+int graph_neighbours(Graph g, int vertex, int *buffer)
+{
+    if (g->rep == sparse)
+        return sparse_row(g, vertex, buffer, 1);
+    return matrix_row_to_list(g, vertex, buffer);
+}
+
+/* graph_eliminate_vertex for the sparse representation */
+int sparse_eliminate_vertex(Graph g, int vertex, int *neighbourhood)
+{
+    struct sparse_adjacency *s = g->sparse;
+    int *neighbours = s->list_vertex;
+    int *missing = s->list_other;
+    int degree = sparse_row(g, vertex, neighbours, 1);
+    long added = 0;
+
+    /* To form a clique every neighbour gets the neighbours
+        of vertex it is not yet connected to as fill edges */
+    for (int i = 0; i < degree; i++)
     {
-        buffer[i] = neighbour;
-        i++;
+        int neighbour = neighbours[i];
+        int count = sparse_row(g, neighbour, s->list_neighbour, 1);
+        int stamp = sparse_next_stamp(g);
+        for (int j = 0; j < count; j++)
+            s->mark[s->list_neighbour[j]] = stamp;
+
+        int missing_count = 0;
+        for (int j = 0; j < degree; j++)
+        {
+            int other = neighbours[j];
+            if (other != neighbour && s->mark[other] != stamp)
+                missing[missing_count++] = other;
+        }
+        if (missing_count == 0)
+            continue;
+        /* The neighbour is alive, so entries to deleted vertices
+            in its row are no longer needed and can be dropped */
+        if (!adjset_merge(&s->fill[neighbour], missing, missing_count, s->deleted))
+        {
+            fprintf(stderr, "Out of memory eliminating vertex %d\n", vertex);
+            abort();
+        }
+        g->degree[neighbour] += missing_count;
+        added += missing_count;
     }
-    return i;
+    /* every new edge was added from both of its ends */
+    g->m += added / 2;
+
+    if (neighbourhood)
+        memcpy(neighbourhood, neighbours, sizeof(int) * degree);
+    graph_delete_vertex(g, vertex);
+    return degree;
 }
 
 /* eliminate a vertex from the graph
@@ -785,40 +1644,47 @@ int convert_bit_field_to_list(char* pointer, int size, int *buffer) {
 */
 int graph_eliminate_vertex(Graph g, int vertex, int *neighbourhood)
 {
-    char need_to_free = 0;
     if (node_invalid(g, vertex))
         return -1; // TODO: what to return?
+    if (g->rep == sparse)
+        return sparse_eliminate_vertex(g, vertex, neighbourhood);
     
-    int degree = g->nodes[vertex]->degree;
+    int degree = g->degree[vertex];
     assert(!(degree < 0));
-    if (!neighbourhood) {
-        neighbourhood = (int*)malloc(sizeof(int)*degree);
-        need_to_free = 1;
-    }
+    struct arena_mark mark = arena_get_mark(&g->scratch);
+    if (!neighbourhood)
+        neighbourhood = (int*)graph_scratch(g, sizeof(int)*degree);
     /* get the list of neighbours */
-    convert_bit_field_to_list(g->adjacency_matrix[vertex], g->adjacency_size, neighbourhood);
+    matrix_row_to_list(g, vertex, neighbourhood);
 
     /* To form a clique we have to bitwise-OR the adjacency
         list of vertex to all its neighbours */
-    for (size_t i = 0; i < degree; i++)
+    char *row = matrix_row(g, vertex);
+    uint64_t *vertex_summary = row_summary(g, vertex);
+    long added = 0;
+    for (int i = 0; i < degree; i++)
     {
         int neighbour = neighbourhood[i];
-        char* work = (char*)aligned_alloc(ALIGNMENT, g->adjacency_size);
-        memset(work, 0, g->adjacency_size);
-        bitwise_or(work,
-                    g->adjacency_matrix[neighbour],
-                    g->adjacency_matrix[vertex],
-                    g->adjacency_size);
+        char *neighbour_row = matrix_row(g, neighbour);
+        /* The new neighbours are the ones of vertex that neighbour
+            is not connected to yet, apart from neighbour itself */
+        int new_edges = count_and_not(row, neighbour_row, g->adjacency_size) - 1;
+        if (new_edges <= 0)
+            continue;
+        bitwise_or(neighbour_row, neighbour_row, row, g->adjacency_size);
+        uint64_t *summary = row_summary(g, neighbour);
+        for (int j = 0; j < g->summary_size; j++)
+            summary[j] |= vertex_summary[j];
         /* Remove neighbour from its own adjacency list */
-        work[neighbour / 8] &= ~(0x1 << (7 - neighbour % 8));
+        matrix_clear(g, neighbour, neighbour);
 
-        /* Update adjacency matrix and degree of neighbour*/
-        free(g->adjacency_matrix[neighbour]);
-        g->adjacency_matrix[neighbour] = work;
-        g->nodes[neighbour]->degree = number_of_set_bits(work, g->adjacency_size); 
-    }    
+        g->degree[neighbour] += new_edges;
+        added += new_edges;
+    }
+    /* every new edge was added from both of its ends */
+    g->m += added / 2;
     graph_delete_vertex(g, vertex);
-    if (need_to_free) free(neighbourhood);
+    arena_reset(&g->scratch, mark);
     return degree;
 }
 
@@ -826,30 +1692,44 @@ void graph_delete_vertex(Graph g, int vertex)
 {
     if (node_invalid(g, vertex))
         return;
-    struct node_t *current = g->nodes[vertex];
-    int *neighbours = (int*)malloc(sizeof(int)*current->degree);
-    convert_bit_field_to_list(g->adjacency_matrix[vertex], g->adjacency_size, neighbours);
+    if (g->rep == sparse)
+    {
+        /* Only the degrees change, the row entries pointing
+            to vertex are skipped from now on */
+        int count = sparse_row(g, vertex, g->sparse->list_neighbour, 1);
+        for (int i = 0; i < count; i++)
+            g->degree[g->sparse->list_neighbour[i]]--;
+        g->m -= count;
+        priority_delete_node(g, vertex);
+        g->is_deleted[vertex] = 1;
+        g->n--;
+        return;
+    }
+    struct arena_mark mark = arena_get_mark(&g->scratch);
+    int degree = g->degree[vertex];
+    int *neighbours = (int*)graph_scratch(g, sizeof(int)*degree);
+    matrix_row_to_list(g, vertex, neighbours);
     /* Delete all edges from its neighbours to vertex. Notice that we do not delete
         the edges originating from vertex. This is so we can
         use the adjacency_matrix for the conversion to tree decomposition
         after all vertices have been eliminated. 
     */
-    for (int i = 0; i < current->degree; i++)
+    for (int i = 0; i < degree; i++)
     {
         int neighbour = neighbours[i];
         graph_delete_edge(g, neighbour, vertex);
     }
     priority_delete_node(g, vertex);
-    current->is_deleted = 1;
+    g->is_deleted[vertex] = 1;
     g->n--;
-    free(neighbours);
+    arena_reset(&g->scratch, mark);
 }
 
 void graph_delete_edge(Graph g, int vertex1, int vertex2)
 {
 
-    g->adjacency_matrix[vertex1][vertex2 / 8] &= ~(0x1 << (7 - vertex2 % 8));
-    g->nodes[vertex1]->degree--;
+    matrix_clear(g, vertex1, vertex2);
+    g->degree[vertex1]--;
     g->m--;
 }
 
@@ -863,16 +1743,123 @@ int graph_edge_count(Graph g)
     return g->m;
 }
 
+int graph_degree(Graph g, int vertex)
+{
+    if (node_invalid(g, vertex))
+        return -1;
+    return g->degree[vertex];
+}
+
+int graph_common_neighbours(Graph g, int vertex, int other)
+{
+    if (g->rep != sparse)
+        return count_and(matrix_row(g, vertex), matrix_row(g, other), g->adjacency_size);
+    struct sparse_adjacency *s = g->sparse;
+    int stamp = sparse_next_stamp(g);
+    int count = sparse_row(g, vertex, s->list_neighbour, 1);
+    for (int i = 0; i < count; i++)
+        s->mark[s->list_neighbour[i]] = stamp;
+    count = sparse_row(g, other, s->list_other, 1);
+    int common = 0;
+    for (int i = 0; i < count; i++)
+        common += s->mark[s->list_other[i]] == stamp;
+    return common;
+}
+
+Graph graph_induced(Graph g, const int *vertices, int count, int *map)
+{
+    int n = g->nodes_len;
+    /* the buffer only has to hold the rows of the vertices taken */
+    int max_degree = 0;
+    for (int k = 0; k < count; k++)
+    {
+        if (graph_degree(g, vertices[k]) > max_degree)
+            max_degree = graph_degree(g, vertices[k]);
+    }
+    int *relabel = map ? map : (int *)malloc(sizeof(int) * (n + 1));
+    int *row = (int *)malloc(sizeof(int) * (max_degree + 1));
+    Graph h = graph_create_representation(count, g->rep);
+    if (!relabel || !row || !h)
+    {
+        if (!map)
+            free(relabel);
+        free(row);
+        graph_destroy(h);
+        return NULL;
+    }
+    h->numbering = g->numbering;
+    if (!map)
+        memset(relabel, -1, sizeof(int) * n);
+    for (int k = 0; k < count; k++)
+        relabel[vertices[k]] = k;
+
+    size_t entries = 0;
+    for (int k = 0; k < count; k++)
+    {
+        int len = graph_neighbours(g, vertices[k], row);
+        int degree = 0;
+        for (int i = 0; i < len; i++)
+        {
+            int label = relabel[row[i]];
+            if (label < 0)
+                continue;
+            if (h->rep != sparse)
+                matrix_set(h, k, label);
+            degree++;
+        }
+        h->degree[k] = degree;
+        entries += degree;
+    }
+    h->m = entries / 2;
+    if (h->rep == sparse)
+    {
+        /* the vertices are ascending, so relabeling keeps
+            the rows sorted */
+        struct sparse_adjacency *sp = h->sparse;
+        sp->csr_targets = (int *)malloc(sizeof(int) * (entries > 0 ? entries : 1));
+        if (!sp->csr_targets)
+        {
+            graph_destroy(h);
+            h = NULL;
+        }
+        else
+            sp->csr_offsets[0] = 0;
+        for (int k = 0; h && k < count; k++)
+        {
+            int len = graph_neighbours(g, vertices[k], row);
+            int end = sp->csr_offsets[k];
+            for (int i = 0; i < len; i++)
+            {
+                if (relabel[row[i]] >= 0)
+                    sp->csr_targets[end++] = relabel[row[i]];
+            }
+            sp->csr_offsets[k + 1] = end;
+        }
+    }
+    if (map)
+    {
+        /* all -1 again for the next call */
+        for (int k = 0; k < count; k++)
+            map[vertices[k]] = -1;
+    }
+    else
+        free(relabel);
+    free(row);
+    return h;
+}
+
 int graph_vertex_priority(Graph g, int vertex)
 {
-    if (node_invalid(g, vertex) || g->nodes[vertex]->in_set)
+    if (node_invalid(g, vertex) || g->in_set[vertex])
         return -1;
-    return g->nodes[vertex]->priority_index;
+    return g->priority_index[vertex];
 }
 
 int graph_has_edge(Graph g, int source, int sink)
 {
-    return g->adjacency_matrix[source][sink / 8] & 1 << (7 - sink % 8);
+    if (g->rep == sparse)
+        return !g->is_deleted[sink] && sparse_row_contains(g, source, sink);
+    return matrix_row(g, source)[sink / 8] & 1 << (sink % 8);
 }
 
 int graph_min_vertex(Graph g,
@@ -901,154 +1888,539 @@ void calc_initial_degrees(Graph g)
     {
         if (node_invalid(g, i))
             continue;
-        g->nodes[i]->priority_index = g->nodes[i]->degree;
-        priority_add_node(g, i, g->nodes[i]->priority_index);
+        g->priority_index[i] = g->degree[i];
     }
+    priority_build(g);
 }
 
-/*  Initialise the priority lists with 0 for every node
-    for later use with the mcs method */
-void calc_initial_mcs(Graph g)
+/* node_calc_fillin for the sparse representation with the
+    scratch arrays given: <mark> is stamped with <stamp>,
+    <neighbours> and <row> hold nodes_len entries. Only
+    reads the graph otherwise */
+int sparse_count_fillin(Graph g, int node, int *mark, int stamp,
+                        int *neighbours, int *row)
 {
-    /* The cardinality set is still empty, so every
-        node is in the 0 set
-    */
-    for (int i = 0; i < g->nodes_len; i++)
+    int degree = sparse_row(g, node, neighbours, 1);
+    for (int i = 0; i < degree; i++)
+        mark[neighbours[i]] = stamp;
+
+    long fill_in_edges = 0;
+    for (int i = 0; i < degree; i++)
     {
-        if (node_invalid(g, i))
-            continue;
-        priority_add_node(g, i, 0);
+        /* every neighbour of node not adjacent to neighbours[i]
+            (apart from itself) needs an edge */
+        int count = sparse_row(g, neighbours[i], row, 1);
+        int common = 0;
+        for (int j = 0; j < count; j++)
+        {
+            if (mark[row[j]] == stamp)
+                common++;
+        }
+        fill_in_edges += degree - 1 - common;
     }
+    /* We counted each edge twice */
+    return fill_in_edges / 2;
 }
 
-/*  Initialise priority lists for min-fill-in strategy.
-    A node gets the number of fill-in edges created
-    if it was eliminated from the graph.
-*/
-int node_calc_fillin(Graph g, int node)
+/* node_calc_fillin for the sparse representation */
+int sparse_calc_fillin(Graph g, int node)
 {
-    int degree = g->nodes[node]->degree;
+    struct sparse_adjacency *s = g->sparse;
+    return sparse_count_fillin(g, node, s->mark, sparse_next_stamp(g),
+                               s->list_vertex, s->list_neighbour);
+}
+
+/* node_calc_fillin for the bit matrix with a buffer
+    for the <g->degree[node]> neighbours given */
+int matrix_count_fillin(Graph g, int node, int *neighbours)
+{
+    int degree = g->degree[node];
     int fill_in_edges = 0;
-    int* neighbours = (int*)malloc(sizeof(int)*degree);
-    convert_bit_field_to_list(g->adjacency_matrix[node], g->adjacency_size, neighbours);
-    char* work = (char*)aligned_alloc(ALIGNMENT, g->adjacency_size);
+    matrix_row_to_list(g, node, neighbours);
 
     for (int neighbour = 0; neighbour < degree; neighbour++)
     {
-        /* Calculate the edges to add for neighbour */
-        calculate_uncommon_neigbours(work, NULL, g->adjacency_matrix[node], 
-                    g->adjacency_matrix[neighbours[neighbour]], g->adjacency_size);
-        /* Subtract 1 because neighbour needs no edge to itself */
-        fill_in_edges += number_of_set_bits(work, g->adjacency_size) - 1;        
+        /* Count the edges to add for neighbour.
+            Subtract 1 because neighbour needs no edge to itself */
+        fill_in_edges += count_and_not(matrix_row(g, node),
+                    matrix_row(g, neighbours[neighbour]), g->adjacency_size) - 1;
     }
     /* We counted each edge twice */
     fill_in_edges = fill_in_edges / 2;
+    return fill_in_edges;
+}
 
-    free(neighbours);
-    free(work);
+/*  Initialise priority lists for min-fill-in strategy.
+    A node gets the number of fill-in edges created
+    if it was eliminated from the graph.
+*/
+int node_calc_fillin(Graph g, int node)
+{
+    if (g->rep == sparse)
+        return sparse_calc_fillin(g, node);
+    struct arena_mark mark = arena_get_mark(&g->scratch);
+    int* neighbours = (int*)graph_scratch(g, sizeof(int)*g->degree[node]);
+    int fill_in_edges = matrix_count_fillin(g, node, neighbours);
+    arena_reset(&g->scratch, mark);
     return fill_in_edges;
 }
 
+/* vertices a thread takes at once in calc_initial_fillin */
+#define FILLIN_CHUNK 64
+/* below this many vertices the threads are not worth starting */
+#define FILLIN_PARALLEL_MIN 1024
+
+/* the initial fill-in computation shared by the threads */
+struct fillin_job
+{
+    Graph g;
+    atomic_int next; /* first vertex of the next chunk */
+};
+
+/* compute the fill-in of chunks of vertices until none are left,
+    into g->priority_index. The graph is only read, the scratch
+    buffers are the thread's own */
+void *calc_fillin_worker(void *arg)
+{
+    struct fillin_job *job = (struct fillin_job *)arg;
+    Graph g = job->g;
+    int n = g->nodes_len;
+    int *neighbours = (int *)malloc(sizeof(int) * (n + 1));
+    int *row = NULL, *mark = NULL;
+    if (g->rep == sparse)
+    {
+        row = (int *)malloc(sizeof(int) * (n + 1));
+        mark = (int *)calloc(n + 1, sizeof(int));
+    }
+    if (!neighbours || (g->rep == sparse && (!row || !mark)))
+    {
+        fprintf(stderr, "Out of memory\n");
+        abort();
+    }
+    int stamp = 0;
+    int start;
+    while ((start = atomic_fetch_add(&job->next, FILLIN_CHUNK)) < n)
+    {
+        int end = start + FILLIN_CHUNK < n ? start + FILLIN_CHUNK : n;
+        for (int i = start; i < end; i++)
+        {
+            if (node_invalid(g, i))
+                continue;
+            if (g->rep == sparse)
+            {
+                if (stamp == INT_MAX)
+                {
+                    memset(mark, 0, sizeof(int) * n);
+                    stamp = 0;
+                }
+                g->priority_index[i] = sparse_count_fillin(g, i, mark, ++stamp, neighbours, row);
+            }
+            else
+                g->priority_index[i] = matrix_count_fillin(g, i, neighbours);
+        }
+    }
+    free(neighbours);
+    free(row);
+    free(mark);
+    return NULL;
+}
+
 /* Calculate the number of fill-in edges for
     every vertex and populate the priority lists
     accordingly
 */
 void calc_initial_fillin(Graph g)
 {
-    for (int i = 0; i < g->nodes_len; i++)
+    /* The fill-in of every vertex only depends on the graph,
+        so the vertices are split between <g->threads> threads.
+        The priority lists are built afterwards */
+    struct fillin_job job = {g, 0};
+    int threads = g->threads > 1 && g->nodes_len >= FILLIN_PARALLEL_MIN ? g->threads : 1;
+    pthread_t *workers = threads > 1 ? (pthread_t *)malloc(sizeof(pthread_t) * threads) : NULL;
+    int started = 0;
+    for (; workers && started < threads - 1; started++)
     {
-        if (node_invalid(g, i))
-            continue;
-        int fillin = node_calc_fillin(g, i);
-        priority_add_node(g, i, fillin);
+        if (pthread_create(&workers[started], NULL, calc_fillin_worker, &job) != 0)
+            break; /* the others take over its part */
     }
+    calc_fillin_worker(&job);
+    for (int i = 0; i < started; i++)
+        pthread_join(workers[i], NULL);
+    free(workers);
+    priority_build(g);
 }
 
 /*  Update the priority lists for min-degree method
-    upon eliminating the node g->nodes[node]
+    upon eliminating the node <node>
 */
 void node_update_priority_degree(Graph g, int node)
 {
 
-    int newpriority = g->nodes[node]->degree;
-    if (g->nodes[node]->priority_index == newpriority)
+    int newpriority = g->degree[node];
+    if (g->priority_index[node] == newpriority)
         return;
     priority_delete_node(g, node);
     priority_add_node(g, node, newpriority);
 }
 
+/* Tie break of MCS.
+    The vertices of every cardinality set are kept in a binary
+    heap as well, ordered by degree (smallest first for mcs_tie_min,
+    largest first for mcs_tie_max) and then by the time they joined
+    the set, which is the order of the set's list. As long as no
+    vertex is eliminated, the degree among the vertices not included
+    yet is the degree minus the cardinality, so comparing the degrees
+    within one set is enough and the keys never change.
+    Vertices that move up to the next set are not removed from the
+    heap but skipped once they reach the top (their time does not
+    match any more), a heap with more of those than members is
+    rebuilt from the list of its set.
+    With random ties a random key takes the place of the time.
+*/
+struct mcs_item
+{
+    int vertex;
+    int joined;   /* when <vertex> joined the set */
+    uint32_t key; /* order among equal degrees */
+};
+
+struct mcs_heap
+{
+    struct mcs_item *items;
+    int size;
+    int capacity;
+};
+
+struct mcs_state
+{
+    mcs_tie tie;
+    struct mcs_heap *heaps; /* one per cardinality */
+    int *members;           /* number of vertices in each set */
+    int *joined;            /* when a vertex joined its current set */
+    int clock;
+};
+
+/* return 1 if <a> should be included before <b> */
+static inline int mcs_before(Graph g, const struct mcs_state *st,
+                             struct mcs_item a, struct mcs_item b)
+{
+    int da = g->degree[a.vertex], db = g->degree[b.vertex];
+    if (da != db)
+        return st->tie == mcs_tie_min ? da < db : da > db;
+    if (a.key != b.key)
+        return a.key < b.key;
+    return a.joined < b.joined;
+}
+
+/* the heap entry of <vertex> in its current set */
+static inline struct mcs_item mcs_entry(Graph g, const struct mcs_state *st, int vertex)
+{
+    int joined = st->joined[vertex];
+    uint32_t key = g->random_ties ? (uint32_t)(graph_random(g) >> 32) : (uint32_t)joined;
+    return (struct mcs_item){vertex, joined, key};
+}
+
+static void mcs_sift_up(Graph g, const struct mcs_state *st, struct mcs_heap *h, int pos)
+{
+    struct mcs_item item = h->items[pos];
+    while (pos > 0)
+    {
+        int parent = (pos - 1) / 2;
+        if (!mcs_before(g, st, item, h->items[parent]))
+            break;
+        h->items[pos] = h->items[parent];
+        pos = parent;
+    }
+    h->items[pos] = item;
+}
+
+static void mcs_sift_down(Graph g, const struct mcs_state *st, struct mcs_heap *h, int pos)
+{
+    struct mcs_item item = h->items[pos];
+    for (;;)
+    {
+        int child = 2 * pos + 1;
+        if (child >= h->size)
+            break;
+        if (child + 1 < h->size && mcs_before(g, st, h->items[child + 1], h->items[child]))
+            child++;
+        if (!mcs_before(g, st, h->items[child], item))
+            break;
+        h->items[pos] = h->items[child];
+        pos = child;
+    }
+    h->items[pos] = item;
+}
+
+/* put <vertex>, which just joined set <index>, into the heap of that set */
+static void mcs_heap_insert(Graph g, struct mcs_state *st, int index, int vertex)
+{
+    struct mcs_heap *h = &st->heaps[index];
+    if (h->size >= 2 * st->members[index])
+    {
+        /* mostly skipped vertices, rebuild from the list (which
+            contains <vertex> already) */
+        h->size = 0;
+        for (int v = g->priority->heads[index]; v >= 0; v = g->next[v])
+            h->items[h->size++] = mcs_entry(g, st, v);
+        for (int pos = h->size / 2 - 1; pos >= 0; pos--)
+            mcs_sift_down(g, st, h, pos);
+        return;
+    }
+    if (h->size == h->capacity)
+    {
+        h->capacity = h->capacity ? 2 * h->capacity : 4;
+        h->items = (struct mcs_item *)realloc(h->items, sizeof(struct mcs_item) * h->capacity);
+        if (!h->items)
+        {
+            fprintf(stderr, "Out of memory\n");
+            abort();
+        }
+    }
+    h->items[h->size++] = mcs_entry(g, st, vertex);
+    mcs_sift_up(g, st, h, h->size - 1);
+}
+
+/* move <vertex> to set <index> */
+static void mcs_set_add(Graph g, struct mcs_state *st, int vertex, int index)
+{
+    priority_add_node(g, vertex, index);
+    st->members[index]++;
+    st->joined[vertex] = st->clock++;
+    mcs_heap_insert(g, st, index, vertex);
+}
+
+/* return the vertex of the biggest set to include next */
+static int mcs_select(Graph g, struct mcs_state *st)
+{
+    int index = g->priority->max_ptr;
+    struct mcs_heap *h = &st->heaps[index];
+    for (;;)
+    {
+        struct mcs_item top = h->items[0];
+        h->items[0] = h->items[--h->size];
+        if (h->size > 0)
+            mcs_sift_down(g, st, h, 0);
+        if (!g->in_set[top.vertex] && st->joined[top.vertex] == top.joined)
+            return top.vertex;
+    }
+}
+
 /* Update the the priorities of the neighbours
     when including vertex in the ordering when
     doing MCS strategy
 */
-void node_update_priority_mcs(Graph g, int vertex)
+void node_update_priority_mcs(Graph g, int vertex, struct mcs_state *st)
 {
     /* If a vertex is included, all its neighbours
-        move up in the priority lists by one index
+        that are not included yet move up in the priority
+        lists by one index
     */
-    //assert(!g->nodes[vertex]->in_set);
-    int size = sizeof(int)*g->nodes[vertex]->degree;
-    int* neighbours = (int*)malloc(size);
-    convert_bit_field_to_list(g->adjacency_matrix[vertex], g->adjacency_size, neighbours);
-    for (int i = 0; i < g->nodes[vertex]->degree; i++)
+    //assert(!g->in_set[vertex]);
+    struct arena_mark mark = arena_get_mark(&g->scratch);
+    int* neighbours = (int*)graph_scratch(g, sizeof(int)*g->degree[vertex]);
+    graph_neighbours(g, vertex, neighbours);
+    g->in_set[vertex] = 1;
+    st->members[g->priority_index[vertex]]--;
+    priority_delete_node(g, vertex);
+    for (int i = 0; i < g->degree[vertex]; i++)
     {
         
         int current = neighbours[i];
+        if (g->in_set[current])
+            continue;
+        int index = g->priority_index[current];
+        st->members[index]--;
         priority_delete_node(g, current);
-        priority_add_node(g, current, g->nodes[current]->priority_index + 1);
+        mcs_set_add(g, st, current, index + 1);
     }
-    g->nodes[vertex]->in_set = 1;
-    priority_delete_node(g, vertex);
-    free(neighbours);
+    arena_reset(&g->scratch, mark);
+}
+
+/* Changes of the fill-in counts during one elimination of the
+    min-fill-in strategy. While the clique is formed the count of
+    a vertex goes up and down many times, so the changes are only
+    summed up here and every touched vertex is moved to its new
+    priority list once, when the elimination is done.
+    The vertices are moved in the order of their last change, which
+    leaves the lists in the same order as moving them every time.
+*/
+struct fillin_batch
+{
+    int *delta;       /* nodes_len entries, 0 outside of an elimination */
+    char *is_touched; /* nodes_len entries */
+    int *next;        /* list of the touched vertices, ordered */
+    int *prev;        /* by their last change */
+    int first;
+    int last;
+};
+
+static inline void fillin_batch_add(struct fillin_batch *b, int vertex, int change)
+{
+    b->delta[vertex] += change;
+    if (b->is_touched[vertex])
+    {
+        if (vertex == b->last)
+            return;
+        /* unlink, it goes to the end again */
+        int prev = b->prev[vertex], next = b->next[vertex];
+        if (prev >= 0)
+            b->next[prev] = next;
+        else
+            b->first = next;
+        b->prev[next] = prev;
+    }
+    b->is_touched[vertex] = 1;
+    b->prev[vertex] = b->last;
+    b->next[vertex] = -1;
+    if (b->last >= 0)
+        b->next[b->last] = vertex;
+    else
+        b->first = vertex;
+    b->last = vertex;
+}
+
+/* move the touched vertices to their new priority lists */
+static void fillin_batch_apply(Graph g, struct fillin_batch *b)
+{
+    for (int vertex = b->first; vertex >= 0; vertex = b->next[vertex])
+    {
+        int current = g->priority_index[vertex];
+        priority_delete_node(g, vertex);
+        priority_add_node(g, vertex, current + b->delta[vertex]);
+        b->delta[vertex] = 0;
+        b->is_touched[vertex] = 0;
+    }
+    b->first = b->last = -1;
+}
+
+/* node_update_priority_fillin_and_eliminate_vertex for the
+    sparse representation. The updates are the same as for
+    the bit matrix (see below), but the set operations are done
+    by marking the rows of vertex and neighbour.
+*/
+int sparse_update_priority_fillin_and_eliminate_vertex(Graph g, int vertex, struct fillin_batch *batch)
+{
+    struct sparse_adjacency *s = g->sparse;
+    int *vertex_neighbours = s->list_vertex;
+    int degree = sparse_row(g, vertex, vertex_neighbours, 1);
+    int vertex_stamp = sparse_next_stamp(g);
+    for (int i = 0; i < degree; i++)
+        s->mark[vertex_neighbours[i]] = vertex_stamp;
+
+    for (int i = 0; i < degree; i++)
+    {
+        int neighbour = vertex_neighbours[i];
+        int count = sparse_row(g, neighbour, s->list_neighbour, 1);
+        int neighbour_stamp = sparse_next_stamp(g);
+
+        /* Neighbours of neighbour which are not adjacent to vertex
+            no longer need an edge to vertex */
+        int decrease = 0;
+        for (int j = 0; j < count; j++)
+        {
+            int other = s->list_neighbour[j];
+            s->mark_neighbour[other] = neighbour_stamp;
+            if (other != vertex && s->mark[other] != vertex_stamp)
+                decrease++;
+        }
+
+        /* Add edges to the clique, only to vertices with higher
+            position than neighbour to avoid doing it twice */
+        for (int j = i + 1; j < degree; j++)
+        {
+            int new_neighbour = vertex_neighbours[j];
+            if (s->mark_neighbour[new_neighbour] == neighbour_stamp)
+                continue;
+            graph_add_edge(g, neighbour, new_neighbour);
+            s->mark_neighbour[new_neighbour] = neighbour_stamp;
+
+            /* Common neighbours would have added this edge as well */
+            int new_count = sparse_row(g, new_neighbour, s->list_other, 1);
+            int common = 0;
+            for (int k = 0; k < new_count; k++)
+            {
+                int common_neighbour = s->list_other[k];
+                if (s->mark_neighbour[common_neighbour] != neighbour_stamp)
+                    continue;
+                common++;
+                if (common_neighbour == vertex)
+                    continue;
+                fillin_batch_add(batch, common_neighbour, -1);
+            }
+
+            /* Exclusive neighbours of one now need an edge to the other,
+                not counting the two themselves */
+            int increase_neighbour = g->degree[neighbour] - common - 1;
+            int increase_new_neighbour = g->degree[new_neighbour] - common - 1;
+            if (increase_neighbour > 0)
+                fillin_batch_add(batch, neighbour, increase_neighbour);
+            if (increase_new_neighbour > 0)
+                fillin_batch_add(batch, new_neighbour, increase_new_neighbour);
+        }
+
+        if (decrease > 0)
+            fillin_batch_add(batch, neighbour, -decrease);
+    }
+    fillin_batch_apply(g, batch);
+    graph_delete_vertex(g, vertex);
+    return degree;
 }
 
 int node_update_priority_fillin_and_eliminate_vertex(Graph g, int vertex, char *common, char *vertex_minus_neighbour,
-                                                     char *neighbour_minus_vertex, char *neighbour1_minus_neigbhour2, char *neighbour2_minus_neighbour1)
+                                                     struct fillin_batch *batch)
 {
     if (node_invalid(g, vertex))
         return -1; // TODO: what to return?
 
-    int degree = g->nodes[vertex]->degree;
+    int degree = g->degree[vertex];
     /* for each vertex of graph */
-    char *adj_list = g->adjacency_matrix[vertex];
+    char *adj_list = matrix_row(g, vertex);
 
     /* get the next neighbour */
-    int neighbour = get_next_bit_index(adj_list,
-                                       0, g->adjacency_size);
+    int neighbour = matrix_next_neighbour(g, vertex, 0);
 
     for (int i = 0; i < degree; i++)
     {
 
         if (node_invalid(g, neighbour)) return -1;
 
-        memset(vertex_minus_neighbour, 0, g->adjacency_size);
-        memset(neighbour_minus_vertex, 0, g->adjacency_size);
+        /* the bit vector operations overwrite their result,
+            no need to clear it before */
         calculate_uncommon_neigbours(
-            vertex_minus_neighbour, neighbour_minus_vertex,
-            adj_list, g->adjacency_matrix[neighbour], g->adjacency_size);
+            vertex_minus_neighbour, NULL,
+            adj_list, matrix_row(g, neighbour), g->adjacency_size);
+
+        /*  Consider the current vertex <a>, its neighbour <b> and
+            a neighbour of b <c> where c is not a neigbour of a.
+            Eliminating b would have required a fill-in edge
+            between a and c. As vertex a is being deleted,
+            this is no longer neccessary, thus decreasing
+            the fill-in count of b by 1. So the fill-in count
+            of b should be decreased by the number of neighbours
+            of b that are not neighbours of a.
+            The edges added below only connect b to neighbours of a,
+            so this number does not change until we apply it.
+        */
+        /*  We need to subtract 1 for the vertex itself
+            since this would imply a loop on vertex, which would not have
+            been added when eliminating neighbour
+        */
+        int decrease = count_and_not(matrix_row(g, neighbour), adj_list,
+                                     g->adjacency_size) - 1;
 
         /* Add edges to the clique:
             vertex_minus_neighbour contains the neighbours
             of vertex which neighbour is not yet connected to.
             Only add edges to vertices with index higher than
             neighbour to avoid doing it twice. */
-        int new_neighbour = get_next_bit_index(vertex_minus_neighbour,
-                                               neighbour + 1, g->adjacency_size);
+        int new_neighbour = bitset_next(vertex_minus_neighbour,
+                                        neighbour + 1, g->adjacency_size);
         while (!node_invalid(g, new_neighbour))
         {
             graph_add_edge(g, neighbour, new_neighbour);
-            memset(common, 0, g->adjacency_size);
-            memset(neighbour1_minus_neigbhour2, 0, g->adjacency_size);
-            memset(neighbour2_minus_neighbour1, 0, g->adjacency_size);
-            calculate_common_uncommon_neighbours(common, neighbour1_minus_neigbhour2, neighbour2_minus_neighbour1,
-                                                 g->adjacency_matrix[neighbour], g->adjacency_matrix[new_neighbour],
-                                                 g->adjacency_size);
-            /* remove new neighbours from each others' exclusive neighbour lists */
-            /* TODO: Could this be achieved by calculating common and uncommon neighbours before
-                adding the edge? 
-            */
-            neighbour1_minus_neigbhour2[new_neighbour / 8] &= ~(1 << (7 - new_neighbour % 8));
-            neighbour2_minus_neighbour1[neighbour / 8] &= ~(1 << (7 - neighbour % 8));
+            bitwise_and(common, matrix_row(g, neighbour), matrix_row(g, new_neighbour),
+                        g->adjacency_size);
 
             /*  Edges that we add now we don't need to add
                 later. Neighbours that are common to
@@ -1057,15 +2429,13 @@ int node_update_priority_fillin_and_eliminate_vertex(Graph g, int vertex, char *
                 for these common neighbours
             */
             /* Remove vertex from common list, as it is being deleted */
-            common[vertex / 8] &= ~(0x1 << (7 - vertex % 8));
-            int common_neighbour = get_next_bit_index(common, 0, g->adjacency_size);
+            set_bit(common, vertex, 0);
+            int common_neighbour = bitset_next(common, 0, g->adjacency_size);
             while (!node_invalid(g, common_neighbour))
             {
-                int current = g->nodes[common_neighbour]->priority_index;
-                priority_delete_node(g, common_neighbour);
-                priority_add_node(g, common_neighbour, current - 1);
-                common_neighbour = get_next_bit_index(common,
-                                                      common_neighbour + 1, g->adjacency_size);
+                fillin_batch_add(batch, common_neighbour, -1);
+                common_neighbour = bitset_next(common,
+                                               common_neighbour + 1, g->adjacency_size);
             }
 
             /*  Since neighbour <a> and new_neighbour <b> are now neighbours,
@@ -1074,54 +2444,28 @@ int node_update_priority_fillin_and_eliminate_vertex(Graph g, int vertex, char *
                 is not a neighbour to <b>. Eliminating <a> would now require
                 to add an edge from <b> to <c>, therefore we must increase
                 the fill-in count by 1 for every exclusive neighbour of <a>.
+                The new neighbours themselves are exclusive to each other
+                now, which is why we subtract 1.
             */
-            int increase_neighbour = number_of_set_bits(neighbour1_minus_neigbhour2, g->adjacency_size);
-            
-            int increase_new_neighbour = number_of_set_bits(neighbour2_minus_neighbour1, g->adjacency_size);
+            int increase_neighbour = count_and_not(matrix_row(g, neighbour),
+                                                   matrix_row(g, new_neighbour), g->adjacency_size) - 1;
+            int increase_new_neighbour = count_and_not(matrix_row(g, new_neighbour),
+                                                       matrix_row(g, neighbour), g->adjacency_size) - 1;
             if (increase_neighbour > 0)
-            {
-                int current = g->nodes[neighbour]->priority_index;
-                priority_delete_node(g, neighbour);
-                priority_add_node(g, neighbour, current+increase_neighbour);
-            }
+                fillin_batch_add(batch, neighbour, increase_neighbour);
             if (increase_new_neighbour > 0)
-            {
-                int current = g->nodes[new_neighbour]->priority_index;
-                priority_delete_node(g, new_neighbour);
-                priority_add_node(g, new_neighbour, current+increase_new_neighbour);
-            }
+                fillin_batch_add(batch, new_neighbour, increase_new_neighbour);
 
-            new_neighbour = get_next_bit_index(vertex_minus_neighbour,
-                                               new_neighbour + 1, g->adjacency_size);
+            new_neighbour = bitset_next(vertex_minus_neighbour,
+                                        new_neighbour + 1, g->adjacency_size);
         }
 
-        /*  Consider the current vertex <a>, its neighbour <b> and
-            a neighbour of b <c> where c is not a neigbour of a.
-            Eliminating b would have required a fill-in edge
-            between a and c. As vertex a is being deleted,
-            this is no longer neccessary, thus decreasing
-            the fill-in count of b by 1. So the fill-in count
-            of b should be decreased by the number of bit in
-            neighbour_minus_vertex.
-        */
-        /*  We need to remove the vertex itself from neighbour_minus_vertex
-            since this would imply a loop on vertex, which would not have
-            been added when eliminating neighbour
-        */
-        neighbour_minus_vertex[vertex / 8] &= ~(1 << (7 - vertex % 8));
-
-        int decrease = number_of_set_bits(neighbour_minus_vertex, g->adjacency_size);
         if (decrease > 0)
-        {
-            int new_priority = g->nodes[neighbour]->priority_index - decrease;
-            //assert(new_priority >= 0);
-            priority_delete_node(g, neighbour);
-            priority_add_node(g, neighbour, new_priority);
-        }
+            fillin_batch_add(batch, neighbour, -decrease);
 
-        neighbour = get_next_bit_index(adj_list,
-                                       neighbour + 1, g->adjacency_size);
+        neighbour = matrix_next_neighbour(g, vertex, neighbour + 1);
     }
+    fillin_batch_apply(g, batch);
     graph_delete_vertex(g, vertex);
     return degree;
 }
@@ -1136,143 +2480,625 @@ void graph_order_abort(Graph g, strategy heuristic, int remaining) {
     if (heuristic == mcs)
     {
         for (int i = remaining; i >= 0; i--) {
-            struct node_t *best_node = g->priority->heads[g->priority->min_ptr];
-            priority_delete_node(g, best_node->id);
-            g->ordering[i] = best_node->id;
+            int best_node = g->priority->heads[g->priority->min_ptr];
+            priority_delete_node(g, best_node);
+            g->ordering[i] = best_node;
         }
         
     } else
     {
+        /* Deleting the vertices of the clique eliminates them
+            without adding any edges, this way the rows keep the
+            bags for graph_write_treedecomp. */
         for (int i = remaining; i < g->nodes_len; i++)
         {
-            struct node_t *best_node = g->priority->heads[g->priority->min_ptr];
-            priority_delete_node(g, best_node->id);
-            g->ordering[i] = best_node->id;
+            int best_node = g->priority->heads[g->priority->min_ptr];
+            graph_delete_vertex(g, best_node);
+            g->ordering[i] = best_node;
         } 
         
     }    
 }
 
+struct ordering_times graph_ordering_times(Graph g)
+{
+    return g->times;
+}
+
+void graph_set_threads(Graph g, int threads)
+{
+    g->threads = threads;
+}
+
+void graph_set_random_ties(Graph g, uint64_t seed)
+{
+    /* splitmix64 of the seed, the state must not be 0 */
+    uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    g->random_state = z ? z : 1;
+    g->random_ties = 1;
+}
+
+void graph_set_width_bound(Graph g, atomic_int *bound)
+{
+    g->width_bound = bound;
+}
+
+int graph_order(Graph g, strategy heuristic, mcs_tie tie)
+{
+    switch (heuristic)
+    {
+    case degree:
+        return graph_order_degree(g);
+    case fillin:
+        return graph_order_fillin(g);
+    case mcs:
+        return graph_order_mcs(g, tie);
+    case amd:
+        return graph_order_amd(g);
+    default:
+        return -1;
+    }
+}
+
 int graph_order_degree(Graph g)
 {
     int size = graph_vertex_count(g);
     int width = 0;
+    double start = timing_now();
     calc_initial_degrees(g);
+    double initialised = timing_now();
     /* Buffer for neighbours of eliminated vertex */
-    int *neighbours = (int *)malloc(sizeof(int) * g->nodes_len);
-    /* Highest index that might be set */
-    int d = g->n;
+    struct arena_mark mark = arena_get_mark(&g->scratch);
+    int *neighbours = (int *)graph_scratch(g, sizeof(int) * g->nodes_len);
     for (int i = 0; i < size; i++)
     {
-        struct node_t *best_node = g->priority->heads[g->priority->min_ptr];
-        memset(neighbours, 0, sizeof(int)*d);
-        int d = best_node->degree;
-        int current_width = graph_eliminate_vertex(g, best_node->id, neighbours);
+        int best_node = priority_pick(g, g->priority->min_ptr);
+        /* graph_eliminate_vertex overwrites the first d entries */
+        int d = g->degree[best_node];
+        int current_width = graph_eliminate_vertex(g, best_node, neighbours);
         if (current_width > width)
             width = current_width;
-        g->ordering[i] = best_node->id;
+        if (g->width_bound && width > atomic_load(g->width_bound))
+        {
+            arena_reset(&g->scratch, mark);
+            return ORDER_CUTOFF;
+        }
+        g->ordering[i] = best_node;
         /* update index of the neighbours in priority lists */
         for (int j = 0; j < d; j++)
         {
             node_update_priority_degree(g, neighbours[j]);
         }
     }
-    free(neighbours);
+    arena_reset(&g->scratch, mark);
+    g->times.initial = initialised - start;
+    g->times.ordering = timing_now() - initialised;
+    g->times.width = 0;
+    graph_set_elimination(g, g);
     return width;
 }
 
 int graph_order_fillin(Graph g)
 {
     /* create bit vectors for calculations*/
-    char *common = (char*)aligned_alloc(ALIGNMENT, g->adjacency_size);
-    char *vertex_minus_neighbour = (char*)aligned_alloc(ALIGNMENT, g->adjacency_size);
-    char *neighbour_minus_vertex = (char*)aligned_alloc(ALIGNMENT, g->adjacency_size);
-    char *neighbour1_minus_neighbour2 = (char*)aligned_alloc(ALIGNMENT, g->adjacency_size);
-    char *neighbour2_minus_neighbour1 = (char*)aligned_alloc(ALIGNMENT, g->adjacency_size);
+    char *common = NULL, *vertex_minus_neighbour = NULL;
+    struct arena_mark mark = arena_get_mark(&g->scratch);
+    if (g->rep != sparse)
+    {
+        common = (char*)graph_scratch(g, g->adjacency_size);
+        vertex_minus_neighbour = (char*)graph_scratch(g, g->adjacency_size);
+    }
+    struct fillin_batch batch;
+    batch.delta = (int*)graph_scratch(g, sizeof(int) * g->nodes_len);
+    batch.is_touched = (char*)graph_scratch(g, g->nodes_len);
+    batch.next = (int*)graph_scratch(g, sizeof(int) * g->nodes_len);
+    batch.prev = (int*)graph_scratch(g, sizeof(int) * g->nodes_len);
+    batch.first = batch.last = -1;
+    memset(batch.delta, 0, sizeof(int) * g->nodes_len);
+    memset(batch.is_touched, 0, g->nodes_len);
 
     int size = graph_vertex_count(g);
     int width = 0;
+    double start = timing_now();
     calc_initial_fillin(g);
+    double initialised = timing_now();
     for (int i = 0; i < size; i++)
     {
         
         // check if the graph is complete
-        int treshhold = g->n*(g->n - 1)/2;
+        long long treshhold = (long long)g->n*(g->n - 1)/2;
         if (g->m == treshhold)
         {
+            /* every remaining vertex is eliminated with all
+                others as neighbours */
+            if(g->n-1>width) width = g->n-1;
             graph_order_abort(g, fillin, i);
-            if(i-1>width) width = i-1;
             break;
         }
         
-        struct node_t *best_node = g->priority->heads[g->priority->min_ptr];
-        int current_width = node_update_priority_fillin_and_eliminate_vertex(
-            g, best_node->id, common, vertex_minus_neighbour,
-            neighbour_minus_vertex, neighbour1_minus_neighbour2,
-            neighbour2_minus_neighbour1);
+        int best_node = priority_pick(g, g->priority->min_ptr);
+        int current_width;
+        if (g->rep == sparse)
+            current_width = sparse_update_priority_fillin_and_eliminate_vertex(g, best_node, &batch);
+        else
+            current_width = node_update_priority_fillin_and_eliminate_vertex(
+                g, best_node, common, vertex_minus_neighbour, &batch);
         if (current_width < 0) {
             fprintf(stderr, "There was an error calculating current width\n");
+            arena_reset(&g->scratch, mark);
             return -1;
         }
         if (current_width > width)
             width = current_width;
-        g->ordering[i] = best_node->id;
+        g->ordering[i] = best_node;
+        if (g->width_bound && width > atomic_load(g->width_bound))
+        {
+            arena_reset(&g->scratch, mark);
+            return ORDER_CUTOFF;
+        }
 #ifdef VALIDATE_FILLIN
         for (int j = 0; j < g->nodes_len; j++)
         {
             if (node_invalid(g, j))
                 continue;
             int order = node_calc_fillin(g, j);
-            assert(order == g->nodes[j]->priority_index);
+            assert(order == g->priority_index[j]);
         }
 #endif
     }
-    free(common);
-    free(vertex_minus_neighbour);
-    free(neighbour_minus_vertex);
-    free(neighbour1_minus_neighbour2);
-    free(neighbour2_minus_neighbour1);
+    arena_reset(&g->scratch, mark);
+    g->times.initial = initialised - start;
+    g->times.ordering = timing_now() - initialised;
+    g->times.width = 0;
+    graph_set_elimination(g, g);
     return width;
 }
 
-int graph_order_mcs(Graph g)
+int graph_order_mcs(Graph g, mcs_tie tie)
 {
     int size = graph_vertex_count(g);
-    int width = 0;
-    /* need copy to later calculate the width */
-    Graph copy = graph_copy(g);
-    calc_initial_mcs(g);
+    int n = g->nodes_len;
+    double start = timing_now();
+    /* The graph itself is not changed, the sets only need
+        the cardinality of every vertex */
+    struct mcs_state st = {tie, NULL, NULL, NULL, 0};
+    st.heaps = (struct mcs_heap *)calloc(n + 1, sizeof(struct mcs_heap));
+    st.members = (int *)calloc(n + 1, sizeof(int));
+    st.joined = (int *)malloc(sizeof(int) * (n + 1));
+    if (!st.heaps || !st.members || !st.joined)
+    {
+        fprintf(stderr, "Out of memory\n");
+        abort();
+    }
+    /* The cardinality set is still empty, so every
+        node is in the 0 set
+    */
+    st.heaps[0].capacity = n;
+    st.heaps[0].items = (struct mcs_item *)malloc(sizeof(struct mcs_item) * (n + 1));
+    if (!st.heaps[0].items)
+    {
+        fprintf(stderr, "Out of memory\n");
+        abort();
+    }
+    for (int i = 0; i < n; i++)
+    {
+        if (node_invalid(g, i))
+            continue;
+        priority_add_node(g, i, 0);
+        st.members[0]++;
+        st.joined[i] = st.clock++;
+        st.heaps[0].items[st.heaps[0].size++] = mcs_entry(g, &st, i);
+    }
+    for (int pos = st.heaps[0].size / 2 - 1; pos >= 0; pos--)
+        mcs_sift_down(g, &st, &st.heaps[0], pos);
+    double initialised = timing_now();
     /* Do the ordering */
     for (int i = size - 1; i >= 0; i--)
     {
-        /* do a secondary priority -> min degree */
-        struct node_t* best_node = g->priority->heads[g->priority->max_ptr];
-        int best_degree = best_node->degree;
-        struct node_t* next = best_node->next;
-        while (next)
+        int best_node = mcs_select(g, &st);
+        g->ordering[i] = best_node;
+        node_update_priority_mcs(g, best_node, &st);
+    }
+    for (int i = 0; i <= n; i++)
+        free(st.heaps[i].items);
+    free(st.heaps);
+    free(st.members);
+    free(st.joined);
+    double ordered = timing_now();
+
+    /* calculate treewidth
+        As we did not actually do any eliminations, evaluate
+        the ordering on the unchanged graph */
+    int width = graph_ordering_width(g);
+    /* graph_write_treedecomp eliminates the vertices if needed */
+    graph_set_elimination(g, NULL);
+    g->times.initial = initialised - start;
+    g->times.ordering = ordered - initialised;
+    g->times.width = timing_now() - ordered;
+    return width;
+}
+
+int graph_order_amd(Graph g)
+{
+    int n = g->nodes_len;
+    double start = timing_now();
+    /* the quotient graph starts as a copy of the graph in
+        compressed rows with some room for the elements */
+    size_t entries = 0;
+    for (int v = 0; v < n; v++)
+        entries += g->degree[v];
+    size_t capacity = amd_capacity(n, entries);
+    int *offsets = (int*)malloc(sizeof(int) * (n + 1));
+    int *adjacent = (int*)malloc(sizeof(int) * capacity);
+    if (!offsets || !adjacent)
+    {
+        fprintf(stderr, "Out of memory\n");
+        abort();
+    }
+    /* with random ties the vertices are relabeled at random,
+        label k stands for vertex <label[k]> */
+    int *label = NULL, *relabel = NULL;
+    if (g->random_ties)
+    {
+        label = (int*)malloc(sizeof(int) * (n + 1));
+        relabel = (int*)malloc(sizeof(int) * (n + 1));
+        if (!label || !relabel)
+        {
+            fprintf(stderr, "Out of memory\n");
+            abort();
+        }
+        graph_random_permutation(g, label, n);
+        for (int k = 0; k < n; k++)
+            relabel[label[k]] = k;
+    }
+    offsets[0] = 0;
+    for (int k = 0; k < n; k++)
+    {
+        int *row = adjacent + offsets[k];
+        int len = graph_neighbours(g, label ? label[k] : k, row);
+        for (int p = 0; relabel && p < len; p++)
+            row[p] = relabel[row[p]];
+        offsets[k + 1] = offsets[k] + len;
+    }
+    double initialised = timing_now();
+    if (!amd_order(n, offsets, adjacent, capacity, g->ordering))
+    {
+        fprintf(stderr, "Out of memory\n");
+        abort();
+    }
+    for (int i = 0; label && i < n; i++)
+        g->ordering[i] = label[g->ordering[i]];
+    free(label);
+    free(relabel);
+    free(offsets);
+    free(adjacent);
+    double ordered = timing_now();
+
+    /* the degrees were approximate and nothing was
+        eliminated, evaluate the ordering separately */
+    int width = graph_ordering_width(g);
+    graph_set_elimination(g, NULL);
+    g->times.initial = initialised - start;
+    g->times.ordering = ordered - initialised;
+    g->times.width = timing_now() - ordered;
+    return width;
+}
+
+/* number of neighbours <vertex> and <other> have in common.
+    For the sparse representation the neighbours of <vertex>
+    have to be marked with <stamp>, <row> holds nodes_len entries */
+static int lower_bound_common(Graph g, int vertex, int other, int stamp, int *row)
+{
+    if (g->rep != sparse)
+        return count_and(matrix_row(g, vertex), matrix_row(g, other), g->adjacency_size);
+    int count = sparse_row(g, other, row, 1);
+    int common = 0;
+    for (int i = 0; i < count; i++)
+        common += g->sparse->mark[row[i]] == stamp;
+    return common;
+}
+
+/* the neighbour <vertex> is contracted into: the one of
+    smallest degree, with lb_least_c the one with the fewest
+    common neighbours (ties by degree) */
+static int lower_bound_partner(Graph g, int vertex, lower_bound method,
+                               const int *neighbours, int degree, int *row)
+{
+    int stamp = 0;
+    if (method == lb_least_c && g->rep == sparse)
+    {
+        stamp = sparse_next_stamp(g);
+        for (int i = 0; i < degree; i++)
+            g->sparse->mark[neighbours[i]] = stamp;
+    }
+    int best = -1, best_common = INT_MAX;
+    for (int i = 0; i < degree; i++)
+    {
+        int u = neighbours[i];
+        int common = method == lb_least_c ? lower_bound_common(g, vertex, u, stamp, row) : 0;
+        if (best < 0 || common < best_common ||
+            (common == best_common && g->degree[u] < g->degree[best]))
+        {
+            best = u;
+            best_common = common;
+        }
+    }
+    return best;
+}
+
+/*  Lower bound of a single method on a clone of g.
+    The vertices are kept in the priority lists by degree like
+    in graph_order_degree. A vertex of minimum degree is taken
+    and the bound raised to its degree; then it is deleted
+    (degeneracy) or contracted into a neighbour (minor-min-width).
+    Contracting merges the edge, the graph stays a minor of g,
+    whose treewidth can not exceed the one of g, and the minimum
+    degree of a graph is a lower bound of its treewidth. */
+static int graph_lower_bound_single(Graph g, lower_bound method)
+{
+    Graph h = graph_clone(g);
+    if (!h)
+        return -1;
+    calc_initial_degrees(h);
+    int *neighbours = (int *)graph_scratch(h, sizeof(int) * h->nodes_len);
+    int *row = (int *)graph_scratch(h, sizeof(int) * h->nodes_len);
+    int bound = 0;
+    /* a graph of n vertices has no degree above n - 1 */
+    while (h->n - 1 > bound)
+    {
+        int vertex = h->priority->heads[h->priority->min_ptr];
+        int degree = graph_neighbours(h, vertex, neighbours);
+        if (degree > bound)
+            bound = degree;
+        if (method != lb_degeneracy && degree > 0)
         {
-            if (next->degree < best_degree) {
-                best_node = next;
-                best_degree = next->degree;
+            int partner = lower_bound_partner(h, vertex, method, neighbours, degree, row);
+            for (int i = 0; i < degree; i++)
+            {
+                if (neighbours[i] != partner)
+                    graph_add_edge(h, partner, neighbours[i]);
             }
-            next = next->next;
         }
-        
-        g->ordering[i] = best_node->id;
-        node_update_priority_mcs(g, best_node->id);
-        graph_delete_vertex(g, best_node->id);
+        graph_delete_vertex(h, vertex);
+        for (int i = 0; i < degree; i++)
+            node_update_priority_degree(h, neighbours[i]);
     }
+    graph_destroy(h);
+    return bound;
+}
 
-    /* calculate treewidth
-        As we did not actually do any eliminations we have to do it now */
-    for (int i = 0; i < size; i++)
+int graph_lower_bound(Graph g, lower_bound method)
+{
+    if (method != lb_best)
+        return graph_lower_bound_single(g, method);
+    int bound = -1;
+    for (lower_bound m = lb_degeneracy; m < lb_best; m++)
     {
-        int current_width = graph_eliminate_vertex(copy, g->ordering[i], NULL);
-        if (current_width > width)
-            width = current_width;
+        int single = graph_lower_bound_single(g, m);
+        if (single > bound)
+            bound = single;
     }
-    graph_destroy(copy);
-    return width;
+    return bound;
+}
+
+/* find the leaf of the row subtree of <i> that <j> belongs to,
+    see graph_ordering_width */
+static int ordering_leaf(int i, int j, const int *first, int *maxfirst,
+                         int *prevleaf, int *ancestor, int *jleaf)
+{
+    *jleaf = 0;
+    if (i <= j || first[j] <= maxfirst[i])
+        return -1;
+    /* j is a leaf of the i'th row subtree */
+    maxfirst[i] = first[j];
+    int jprev = prevleaf[i];
+    prevleaf[i] = j;
+    *jleaf = jprev == -1 ? 1 : 2;
+    if (*jleaf == 1)
+        return i;
+    /* least common ancestor of jprev and j, with path compression */
+    int q = jprev;
+    while (q != ancestor[q])
+        q = ancestor[q];
+    for (int s = jprev, sparent; s != q; s = sparent)
+    {
+        sparent = ancestor[s];
+        ancestor[s] = q;
+    }
+    return q;
+}
+
+/* The graph in compressed rows over positions of the ordering of g,
+    row k holds the positions of the neighbours of the vertex at
+    position k. <position> (one entry per vertex) is set to the
+    position of every vertex.
+    return the rows, NULL if there was not enough memory */
+static int *ordering_rows(Graph g, int *position, int *offsets)
+{
+    int n = g->nodes_len;
+    size_t entries = 0;
+    for (int v = 0; v < n; v++)
+        entries += g->degree[v];
+    int *adjacent = (int*)malloc(sizeof(int) * (entries > 0 ? entries : 1));
+    if (!adjacent)
+        return NULL;
+    for (int k = 0; k < n; k++)
+        position[g->ordering[k]] = k;
+    offsets[0] = 0;
+    for (int k = 0; k < n; k++)
+    {
+        int *row = adjacent + offsets[k];
+        int len = graph_neighbours(g, g->ordering[k], row);
+        for (int p = 0; p < len; p++)
+            row[p] = position[row[p]];
+        offsets[k + 1] = offsets[k] + len;
+    }
+    return adjacent;
+}
+
+/* elimination tree of the rows of ordering_rows: the parent of k is
+    the first vertex after k in the completion that is adjacent to it,
+    -1 for a root. <ancestor> is scratch space of n entries. */
+static void ordering_etree(int n, const int *offsets, const int *adjacent,
+                           int *parent, int *ancestor)
+{
+    for (int k = 0; k < n; k++)
+    {
+        parent[k] = -1;
+        ancestor[k] = -1;
+        for (int p = offsets[k]; p < offsets[k + 1]; p++)
+        {
+            int i = adjacent[p];
+            while (i != -1 && i < k)
+            {
+                int next = ancestor[i];
+                ancestor[i] = k;
+                if (next == -1)
+                    parent[i] = k;
+                i = next;
+            }
+        }
+    }
+}
+
+/*  The width of an ordering is the largest number of later
+    neighbours a vertex has upon elimination. Those are the
+    column counts of the chordal completion (the Cholesky factor
+    of the graph in the order of the ordering), which can be
+    computed from the elimination tree without building the
+    completion (Gilbert, Ng and Peyton): the column of j is
+    j plus the union of the rows of its subtree. Working on
+    positions in the ordering, every edge is visited twice and the
+    subtree overlaps are found with a union-find structure, so
+    this takes O(m alpha(m, n)) time and O(n + m) space.
+*/
+int graph_ordering_columns(Graph g, int *columns)
+{
+    int n = g->nodes_len;
+    if (g->n != n)
+        return -1;
+    if (n == 0)
+        return 0;
+
+    int *offsets = (int*)malloc(sizeof(int) * (n + 1));
+    int *work = (int*)malloc(sizeof(int) * 8 * (size_t)n);
+    int *adjacent = offsets && work ? ordering_rows(g, work, offsets) : NULL;
+    if (!adjacent)
+    {
+        free(offsets);
+        free(work);
+        return -1;
+    }
+    int *parent = work + n, *ancestor = work + 2 * n,
+        *post = work + 3 * n, *first = work + 4 * n, *maxfirst = work + 5 * n,
+        *prevleaf = work + 6 * n, *count = work + 7 * n;
+    ordering_etree(n, offsets, adjacent, parent, ancestor);
+
+    /* postorder of the tree, <first>, <maxfirst> and <prevleaf>
+        serve as list heads, links and stack here */
+    int *head = first, *next = maxfirst, *stack = prevleaf;
+    for (int j = 0; j < n; j++)
+        head[j] = -1;
+    for (int j = n - 1; j >= 0; j--)
+    {
+        if (parent[j] == -1)
+            continue;
+        next[j] = head[parent[j]];
+        head[parent[j]] = j;
+    }
+    int k = 0;
+    for (int root = 0; root < n; root++)
+    {
+        if (parent[root] != -1)
+            continue;
+        int top = 0;
+        stack[0] = root;
+        while (top >= 0)
+        {
+            int p = stack[top];
+            int i = head[p];
+            if (i == -1)
+            {
+                top--;
+                post[k++] = p;
+            }
+            else
+            {
+                head[p] = next[i];
+                stack[++top] = i;
+            }
+        }
+    }
+
+    /* first[j] is the first descendant of j in postorder */
+    for (int j = 0; j < n; j++)
+        first[j] = -1;
+    for (k = 0; k < n; k++)
+    {
+        int j = post[k];
+        count[j] = first[j] == -1 ? 1 : 0; /* leaves start with themselves */
+        for (; j != -1 && first[j] == -1; j = parent[j])
+            first[j] = k;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        ancestor[i] = i;
+        maxfirst[i] = -1;
+        prevleaf[i] = -1;
+    }
+    /* count[j] becomes the difference of the column count of j
+        to the sum of those of its children */
+    for (k = 0; k < n; k++)
+    {
+        int j = post[k];
+        if (parent[j] != -1)
+            count[parent[j]]--;
+        for (int p = offsets[j]; p < offsets[j + 1]; p++)
+        {
+            int jleaf;
+            int q = ordering_leaf(adjacent[p], j, first, maxfirst, prevleaf, ancestor, &jleaf);
+            if (jleaf >= 1)
+                count[j]++;
+            if (jleaf == 2)
+                count[q]--;
+        }
+        if (parent[j] != -1)
+            ancestor[j] = parent[j];
+    }
+    /* parents come later in the ordering than their children */
+    int max_count = 0;
+    for (int j = 0; j < n; j++)
+    {
+        if (parent[j] != -1)
+            count[parent[j]] += count[j];
+        if (count[j] > max_count)
+            max_count = count[j];
+        if (columns)
+            columns[j] = count[j] - 1;
+    }
+    free(offsets);
+    free(adjacent);
+    free(work);
+    return max_count - 1;
+}
+
+int graph_ordering_width(Graph g)
+{
+    return graph_ordering_columns(g, NULL);
+}
+
+void graph_set_ordering(Graph g, const int *ordering)
+{
+    memcpy(g->ordering, ordering, sizeof(int) * g->nodes_len);
+    graph_set_elimination(g, NULL);
+}
+
+void graph_get_ordering(Graph g, int *ordering)
+{
+    memcpy(ordering, g->ordering, sizeof(int) * g->nodes_len);
 }
 
 /* checks if every vertex was used exactly once
@@ -1280,18 +3106,20 @@ int graph_order_mcs(Graph g)
 */
 char graph_ordering_plausible(Graph g)
 {
-    char *used = (char *)malloc(g->nodes_len);
-    memset(used, 0, g->nodes_len);
-    for (int i = 0; i < g->nodes_len; i++)
+    char *used = (char *)calloc(g->nodes_len + 1, 1);
+    if (!used)
+        return 0;
+    char plausible = 1;
+    for (int i = 0; i < g->nodes_len && plausible; i++)
     {
         int index = g->ordering[i];
-        if (index == -1)
-            return 0;
-        if (used[index])
-            return 0;
-        used[index] = 1;
+        if (index < 0 || index >= g->nodes_len || used[index])
+            plausible = 0;
+        else
+            used[index] = 1;
     }
-    return 1;
+    free(used);
+    return plausible;
 }
 
 void graph_print(Graph g, FILE *stream)
@@ -1301,20 +3129,21 @@ void graph_print(Graph g, FILE *stream)
     if (stream == NULL)
         return;
 
+    int *neighbours = (int*)malloc(sizeof(int)*g->nodes_len);
     fprintf(stream, "# nodes %d\n", g->n);
     for (int i = 0; i < g->nodes_len; i++)
     {
         fprintf(stream, "%d", i);
-        if (g->nodes[i]->is_deleted)
+        if (g->is_deleted[i])
             fprintf(stream, " d");
-        for (int j = 0; j < g->nodes_len; j++)
+        int count = graph_neighbours(g, i, neighbours);
+        for (int j = 0; j < count; j++)
         {
-            if (!graph_has_edge(g, i, j))
-                continue;
-            fprintf(stream, " %d", j);
+            fprintf(stream, " %d", neighbours[j]);
         }
         fprintf(stream, "\n");
     }
+    free(neighbours);
 }
 
 void graph_print_ordering(Graph g, FILE *stream) {
@@ -1336,10 +3165,9 @@ void eo_to_treedecomp(){}
 void d_print_neighbours(Graph g) {
     int *neighbours = (int*)malloc(sizeof(int)*g->nodes_len);
     for (size_t i = 0; i < g->nodes_len; i++) {
-        memset(neighbours, 0, sizeof(int)*g->nodes_len);
-        convert_bit_field_to_list(g->adjacency_matrix[i], g->adjacency_size, neighbours);
+        int count = graph_neighbours(g, i, neighbours);
         printf("%ld:\t", i);
-        for (size_t j = 0; j < g->nodes[i]->degree; j++)
+        for (size_t j = 0; j < count; j++)
         {
             printf(" %d", neighbours[j]);
         }
@@ -1348,87 +3176,257 @@ void d_print_neighbours(Graph g) {
     free(neighbours);
 }
 
-void print_tree_decomposition(Graph tree, char** bags) {
-    /* print the edges of the tree */
-    int size = sizeof(int)*tree->nodes_len;
-    //size = size % ALIGNMENT == 0 ? size : size/ALIGNMENT * ALIGNMENT + ALIGNMENT;
-    int* neighbours = (int*)malloc(size);
-    for (int i = 0; i < tree->n; i++)
+/* Write the bag of <vertex> of the eliminated graph g to <bag> in
+    ascending order and return its size. The bag is the vertex and
+    its neighbours upon elimination, i.e. the neighbours later in
+    the ordering (<position> maps a vertex to its index there).
+*/
+int treedecomp_bag(Graph g, int vertex, const int *position, int *bag)
+{
+    if (g->rep != sparse)
     {
-        memset(neighbours, 0, sizeof(int)*tree->nodes_len);
-        convert_bit_field_to_list(tree->adjacency_matrix[i], tree->adjacency_size, neighbours);
-        for (int j = 0; j < tree->nodes[i]->degree; j++)
+        /* the row of an eliminated vertex is not changed anymore
+            and holds exactly the later neighbours */
+        matrix_set(g, vertex, vertex);
+        return matrix_row_to_list(g, vertex, bag);
+    }
+    /* The sparse row also holds the neighbours eliminated
+        before <vertex>, filter them out */
+    struct arena_mark mark = arena_get_mark(&g->scratch);
+    int *row = graph_scratch(g, sizeof(int) * g->nodes_len);
+    int count = sparse_row(g, vertex, row, 0);
+    int size = 0;
+    char inserted = 0;
+    for (int j = 0; j < count; j++)
+    {
+        int neighbour = row[j];
+        if (position[neighbour] < position[vertex])
+            continue;
+        if (!inserted && neighbour > vertex)
         {
-            if (neighbours[j]<i) continue;
-            printf("N%d,N%d,\n", i, neighbours[j]);
+            bag[size++] = vertex;
+            inserted = 1;
         }
-        
+        bag[size++] = neighbour;
+    }
+    if (!inserted)
+        bag[size++] = vertex;
+    arena_reset(&g->scratch, mark);
+    return size;
+}
+
+/*  Bag i belongs to the i'th vertex from the end of the ordering.
+    Its parent is the bag of the neighbour eliminated first among
+    the later ones: that neighbour's bag contains the rest of the
+    bag since eliminating it connected all of them. Every bag is
+    visited once, so this is linear in the size of the bags.
+*/
+char graph_write_treedecomp(Graph g, FILE *stream, td_format format) {
+    if (!g->elimination)
+    {
+        /* the ordering (MCS) left the graph as it was */
+        if (g->n != g->nodes_len || !graph_ordering_plausible(g))
+            return 0;
+        for (int i = 0; i < g->nodes_len; i++)
+            graph_eliminate_vertex(g, g->ordering[i], NULL);
+        graph_set_elimination(g, g);
+    }
+    Graph e = g->elimination;
+    int n = g->nodes_len;
+    /* the degrees of eliminated vertices stay as they were upon
+        elimination, the largest bag is the largest of them plus
+        the vertex itself. The pace header needs it first. */
+    int max_bag = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (e->degree[i] + 1 > max_bag)
+            max_bag = e->degree[i] + 1;
+    }
+
+    /* parent[i] is the bag that bag i is attached to in the tree */
+    int* parent = (int*)malloc(sizeof(int)*(n > 0 ? n : 1));
+    int* position = (int*)malloc(sizeof(int)*(n > 0 ? n : 1));
+    int* bag = (int*)malloc(sizeof(int)*(n + 1));
+    struct td_writer *writer = td_writer_open(stream, format, n, max_bag, n);
+    if (!parent || !position || !bag || !writer)
+    {
+        free(parent);
+        free(position);
+        free(bag);
+        if (writer)
+            td_writer_close(writer);
+        return 0;
     }
-    /* print the bags */
-    for (int i = 0; i < tree->n; i++)
+    for (int i = 0; i < n; i++)
+        position[g->ordering[i]] = i;
+
+    for (int i = 0; i < n; i++)
     {
-        int size = number_of_set_bits(bags[i], tree->adjacency_size);
-        memset(neighbours, 0, sizeof(int)*tree->nodes_len);
-        convert_bit_field_to_list(bags[i], tree->adjacency_size, neighbours);
-        printf("N%d,,", i);
-        for (int j = 0; j < size - 1; j++)
+        int vertex = g->ordering[n - i - 1];
+        int size = treedecomp_bag(e, vertex, position, bag);
+        td_writer_bag(writer, i, bag, size);
+        int first = n;
+        for (int j = 0; j < size; j++)
         {
-            printf("%d;", neighbours[j]);
+            if (bag[j] != vertex && position[bag[j]] < first)
+                first = position[bag[j]];
         }
-        printf("%d", neighbours[size - 1]);
-        printf("\n");
-        
+        parent[i] = first < n ? n - first - 1 : -1;
     }
-    free(neighbours);
-    
+    td_writer_tree(writer, parent);
+    free(parent);
+    free(position);
+    free(bag);
+    return td_writer_close(writer);
 }
-void graph_eo_to_treedecomp(Graph g) {
 
-    for (size_t i = 0; i < g->nodes_len; i++)
+/*  The bags of the ordering of g form a tree decomposition with the
+    elimination tree as its tree (see graph_write_treedecomp). Rooted
+    at the bag of the first vertex r of the clique, which holds all of
+    the clique, every vertex is eliminated at the bag closest to the
+    root it appears in, after all bags below. Its remaining neighbours
+    are in that bag then, so the width stays the same, and the clique
+    comes last.
+    Rerooting only turns around the path from r up to its old root,
+    so only the vertices on it move: the bags of a vertex u span its
+    row subtree, which hangs from u, and a u on the path is met first
+    at the lowest node of the path whose subtree holds a neighbour of
+    u. Every other vertex stays at its own bag. With the elimination
+    tree built as in graph_ordering_columns this takes O(m alpha(m, n))
+    without adding the fill-in edges, an ordering that eliminated the
+    vertices already is read from its bags instead. */
+char graph_ordering_clique_last(Graph g, const int *clique, int count, int *ordering)
+{
+    int n = g->nodes_len;
+    if (count == 0)
     {
-        graph_eliminate_vertex(g, g->ordering[i], NULL);
+        memcpy(ordering, g->ordering, sizeof(int) * n);
+        return 1;
     }
-    Graph tree = graph_create(g->nodes_len);
-    for (int i = 0; i < tree->nodes_len; i++)
+    Graph e = g->elimination;
+    if (!e && (g->n != n || !graph_ordering_plausible(g)))
+        return 0;
+    int *offsets = (int *)malloc(sizeof(int) * (n + 1));
+    int *work = (int *)malloc(sizeof(int) * 8 * (size_t)n);
+    int *adjacent = NULL;
+    if (offsets && work)
     {
-        graph_delete_vertex(tree, i);
+        if (!e)
+            adjacent = ordering_rows(g, work, offsets);
+        else
+        {
+            size_t entries = 0;
+            for (int v = 0; v < n; v++)
+                entries += e->degree[v] + 1;
+            adjacent = (int *)malloc(sizeof(int) * (entries + 1));
+        }
     }
-
-    /* the bags of the tree decomposition. bags[0] corresponds to tree->nodes[0], etc.*/
-    char** bags = (char**)malloc(sizeof(char*)*g->nodes_len);
-    /* add first bag/node */
-    tree->nodes[0]->is_deleted = 0;
-    tree->n++;
-    bags[0] = g->adjacency_matrix[g->ordering[g->nodes_len-1]];
-    set_bit(bags[0], g->ordering[g->nodes_len-1],1);
-    
-    int size = g->adjacency_size;
-    char* work = (char*)aligned_alloc(ALIGNMENT, size);
-    for (int i = 1; i < g->nodes_len; i++)
+    char ok = offsets && work && adjacent;
+    if (ok)
     {
-        tree->nodes[i]->is_deleted = 0;
-        int vertex = g->ordering[g->nodes_len - i - 1];
-        char* neighbours = g->adjacency_matrix[vertex];
-        /* search the already existing bags for a bag that contains all of neighbours */
-        for (int j = 0; j < tree->n; j++)
+        int *position = work, *parent = work + n, *ancestor = work + 2 * n,
+            *path = work + 3 * n, *top = work + 4 * n, *met = work + 5 * n,
+            *head = work + 6 * n, *link = work + 7 * n;
+        if (!e)
+            ordering_etree(n, offsets, adjacent, parent, ancestor);
+        else
         {
-            memset(work, 0, size);
-            calculate_uncommon_neigbours(work, NULL, neighbours, bags[j], size);
-            if (number_of_set_bits(work, size) == 0)
+            /* rows of the later neighbours from the bags, the parent
+                is the first of them */
+            for (int k = 0; k < n; k++)
+                position[g->ordering[k]] = k;
+            offsets[0] = 0;
+            for (int k = 0; k < n; k++)
             {
-                bags[i] = neighbours;
-                set_bit(bags[i], vertex, 1);
-                graph_add_edge(tree, i, j);
-                break;
-            }           
+                int *row = adjacent + offsets[k];
+                int size = treedecomp_bag(e, g->ordering[k], position, row);
+                int len = 0;
+                parent[k] = -1;
+                for (int j = 0; j < size; j++)
+                {
+                    int i = position[row[j]];
+                    if (i == k)
+                        continue;
+                    row[len++] = i;
+                    if (parent[k] < 0 || i < parent[k])
+                        parent[k] = i;
+                }
+                offsets[k + 1] = offsets[k] + len;
+            }
+        }
+        /* path[k] is the index of k on the path from r up, -1 off
+            the path, ancestor[i] the path node with index i and
+            top[k] the index of the lowest path node above k */
+        int root = position[clique[0]];
+        for (int i = 1; i < count; i++)
+        {
+            if (position[clique[i]] < root)
+                root = position[clique[i]];
+        }
+        for (int k = 0; k < n; k++)
+            path[k] = -1;
+        int length = 0;
+        for (int k = root; k >= 0; k = parent[k])
+        {
+            ancestor[length] = k;
+            path[k] = length++;
+        }
+        for (int k = n - 1; k >= 0; k--)
+            top[k] = path[k] >= 0 ? path[k] : (parent[k] >= 0 ? top[parent[k]] : -1);
+        /* met[i] is the index of the path node path vertex i is
+            met at, a neighbour below a lower node pulls it down */
+        for (int i = 0; i < length; i++)
+            met[i] = i;
+        for (int k = 0; k < n; k++)
+        {
+            if (top[k] < 0)
+                continue;
+            for (int p = offsets[k]; p < offsets[k + 1]; p++)
+            {
+                int i = path[adjacent[p]];
+                if (i >= 0 && top[k] < met[i])
+                    met[i] = top[k];
+            }
         }
-        tree->n++;        
+        /* the vertices off the path at their own bags, in the order
+            of g, then the path vertices by the node they are met at
+            from the old root down, the clique last */
+        for (int i = 0; i < length; i++)
+            head[i] = -1;
+        for (int i = length - 1; i >= 0; i--)
+        {
+            link[i] = head[met[i]];
+            head[met[i]] = i;
+        }
+        for (int i = 0; i < count; i++)
+            top[position[clique[i]]] = -1;
+        int next = 0;
+        for (int k = 0; k < n; k++)
+        {
+            if (path[k] < 0)
+                ordering[next++] = g->ordering[k];
+        }
+        for (int j = length - 1; j >= 0; j--)
+        {
+            for (int i = head[j]; i >= 0; i = link[i])
+            {
+                if (top[ancestor[i]] >= 0)
+                    ordering[next++] = g->ordering[ancestor[i]];
+            }
+        }
+        for (int i = 0; i < count; i++)
+            ordering[next++] = clique[i];
     }
+    free(offsets);
+    free(adjacent);
     free(work);
-    print_tree_decomposition(tree, bags);
-    free(bags);
-    graph_destroy(tree);
-    
+    return ok;
+}
+
+char graph_eo_to_treedecomp(Graph g, FILE *stream, td_format format) {
+
+    graph_set_elimination(g, NULL);
+    return graph_write_treedecomp(g, stream, format);
 }
 
 /* Expects a single line with space-separated integers */
@@ -1438,7 +3436,8 @@ char graph_import_ordering(Graph g, FILE *fstream) {
     size_t linelen;
     if(getline(&line, &linelen, fstream)<0) {free(line);return 0;}
     if (!line) {free(line);return 0;}
-    char* tok = strtok(line, " ");
+    char *save = NULL;
+    char* tok = strtok_r(line, " ", &save);
     for (size_t i = 0; i < g->nodes_len; i++)
     {
         if (!tok) {free(line);return 0;}
@@ -1448,7 +3447,13 @@ char graph_import_ordering(Graph g, FILE *fstream) {
             free(line);
             return 0;
         }
-        tok = strtok(NULL, " ");
+        if (g->ordering[i] < 0 || g->ordering[i] >= g->nodes_len)
+        {
+            fprintf(stderr, "Vertex %d in ordering does not exist\n", g->ordering[i]);
+            free(line);
+            return 0;
+        }
+        tok = strtok_r(NULL, " ", &save);
     }
     free(line);
     return 1;    
@@ -1,8 +1,32 @@
 /* Based on https://www.cs.yale.edu/homes/aspnes/pinewiki/C(2f)Graphs.html
 */
+#ifndef GRAPH_H
+#define GRAPH_H
+
 #include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+typedef enum strategy { unspecified, degree, fillin, mcs, amd} strategy;
+
+/* which vertex MCS includes first among those with the most
+    included neighbours: the one with the fewest or the most
+    neighbours not included yet */
+typedef enum mcs_tie { mcs_tie_min, mcs_tie_max } mcs_tie;
 
-typedef enum strategy { unspecified, degree, fillin, mcs} strategy;
+/* How the edges of a graph are stored.
+    dense:  n x n bit matrix, fast set operations but
+            needs n^2/8 bytes regardless of the edge count
+    sparse: sorted neighbour lists (the imported edges in
+            compressed sparse row format plus a growable
+            set per vertex for fill-in edges), memory scales
+            with n + m + fill
+    automatic: let the import decide based on size and density
+*/
+typedef enum representation { automatic, dense, sparse } representation;
+
+/* output formats of tree decompositions, see tdwriter.h */
+typedef enum td_format { td_format_csv, td_format_pace, td_format_binary } td_format;
 
 typedef struct graph *Graph;
 
@@ -12,6 +36,34 @@ Graph graph_create(int n);
 /* import a graph from a file in adjacency list format */
 Graph graph_import(FILE *fstream);
 
+/* Same as graph_import but use the representation <rep>
+    for the edges. For <automatic> the bit matrix is used
+    as long as it is small or the graph is dense enough.
+*/
+Graph graph_import_as(FILE *fstream, representation rep);
+
+/* Files starting with the header written by graph_export_binary
+    are loaded as they are, without parsing.
+    Binary files are stored with this extension by the cache of
+    graph_import_path. */
+#define TDBIN_EXTENSION ".tdbin"
+
+/* Import the graph in the file <path> like graph_import_as.
+    If <cache> is set, a text file is also stored in binary
+    format as <path>.tdbin and later imports read that instead,
+    as long as <path> was not modified in between.
+    return NULL if the graph could not be imported */
+Graph graph_import_path(const char *path, representation rep, char cache);
+
+/* Write an imported graph in the binary format (compressed
+    sparse rows behind a versioned header with a checksum).
+    <fstream> has to be seekable.
+    return 1 on success, 0 otherwise */
+char graph_export_binary(Graph g, FILE *fstream);
+
+/* return the representation used for the edges of g */
+representation graph_representation(Graph g);
+
 /* import pre existing ordering from a file
     return 1 on success, 0 otherwise */
 char graph_import_ordering(Graph g, FILE *fstream);
@@ -19,6 +71,11 @@ char graph_import_ordering(Graph g, FILE *fstream);
 /* copy a graph*/
 Graph graph_copy(Graph g);
 
+/* copy a graph for ordering it, like graph_copy but the
+    imported edges of the sparse representation (which never
+    change) are shared with g, so g has to outlive the clone */
+Graph graph_clone(Graph g);
+
 /* free all space used by graph */
 void graph_destroy(Graph);
 
@@ -30,6 +87,34 @@ int graph_edge_count(Graph);
 /* return 1 if edge (source, sink) exists), 0 otherwise */
 int graph_has_edge(Graph, int source, int sink);
 
+/* return the number of neighbours of <vertex>,
+    -1 if it does not exist or was deleted */
+int graph_degree(Graph g, int vertex);
+
+/* write the neighbours of <vertex> to <buffer> in ascending
+    order and return their number */
+int graph_neighbours(Graph g, int vertex, int *buffer);
+
+/* return the number of neighbours <vertex> and <other> share */
+int graph_common_neighbours(Graph g, int vertex, int other);
+
+/* eliminate a vertex from the graph in the context
+   of elimination orderings (delete vertex and
+   connect its neighbours). The neighbours are written
+   to <neighbourhood> if it is not NULL.
+   return the degree of the vertex upon elimination */
+int graph_eliminate_vertex(Graph g, int vertex, int *neighbourhood);
+
+/* Create the subgraph of g induced by the <count> vertices
+    listed in ascending order in <vertices>, vertex k of the
+    result is vertices[k]. The representation is that of g.
+    <map> is scratch space of one entry per vertex of g, all -1,
+    which they are again on return, so callers taking many small
+    subgraphs need not pay for a map of the whole graph each time.
+    NULL allocates one.
+    return NULL on failure */
+Graph graph_induced(Graph g, const int *vertices, int count, int *map);
+
 /* calculate an elimination ordering for g
     according to the min degree heuristic.
     Writes the ordering into set, returns
@@ -44,16 +129,132 @@ int graph_order_degree (Graph g);
 int graph_order_fillin (Graph g);
 
 /* Again same usage, but use 
-    maximum cardinality heuristic.
+    maximum cardinality heuristic. Ties between
+    vertices with the same number of included
+    neighbours are broken by <tie>.
+    The graph is not altered by this one.
+*/
+int graph_order_mcs (Graph g, mcs_tie tie);
+
+/* Approximate minimum degree heuristic (see amd.h), an
+    approximation of graph_order_degree that works on a
+    quotient graph in O(n + m) memory instead of adding the
+    fill-in edges. The graph is not altered by this one either.
+*/
+int graph_order_amd (Graph g);
+
+/* order g with <heuristic> (ties of MCS broken by <tie>),
+    return the width as the graph_order_* function does */
+int graph_order (Graph g, strategy heuristic, mcs_tie tie);
+
+/* Treewidth lower bounds.
+    lb_degeneracy: the largest minimum degree seen while deleting
+                   vertices of minimum degree (MMD)
+    lb_min_d:      minor-min-width (MMD+), the vertex of minimum
+                   degree is contracted into its neighbour of
+                   smallest degree instead of being deleted
+    lb_least_c:    MMD+ contracting into the neighbour with the
+                   fewest common neighbours, usually the best bound
+                   but it counts common neighbours for every edge
+    lb_best:       the largest of the three
 */
-int graph_order_mcs (Graph g);
+typedef enum lower_bound { lb_degeneracy, lb_min_d, lb_least_c, lb_best } lower_bound;
+
+/* Compute a lower bound of the treewidth of g with <method>,
+    on a clone of g, so g is not altered. Every step takes a
+    vertex of minimum degree from the priority lists, degeneracy
+    and min-d run in O(n + m) plus the contracted edges.
+    The graph has to be unchanged (not ordered before).
+    return the bound, -1 if g could not be copied */
+int graph_lower_bound (Graph g, lower_bound method);
+
+/* returned by graph_order_degree and graph_order_fillin
+    if the width exceeds the bound of graph_set_width_bound */
+#define ORDER_CUTOFF -2
+
+/* Break the ties of the heuristics at random, reproducibly
+    for the same <seed>: the priority lists are filled in a random
+    order and one of the first vertices of a list is picked, MCS
+    uses random keys after the degree and AMD sees the vertices
+    relabeled at random. */
+void graph_set_random_ties(Graph g, uint64_t seed);
+
+/* Stop graph_order_degree and graph_order_fillin as soon as the
+    width exceeds *<bound>, which other threads may lower
+    meanwhile. NULL (the default) for no bound. */
+void graph_set_width_bound(Graph g, atomic_int *bound);
+
+/* Wall-clock seconds spent in the phases of the last
+    graph_order_* call on a graph.
+    initial:  computing the initial priorities
+    ordering: selecting and eliminating the vertices
+    width:    determining the width afterwards, only MCS
+              and AMD need this (see graph_ordering_width)
+*/
+struct ordering_times
+{
+    double initial;
+    double ordering;
+    double width;
+};
+
+/* return the phase times of the last ordering of g */
+struct ordering_times graph_ordering_times(Graph g);
+
+/* Use <threads> threads for computing the initial priorities
+    of graph_order_fillin (default 1). Copies use one thread. */
+void graph_set_threads(Graph g, int threads);
 
 /* Convert an elimination ordering to a 
-    tree decomposition.
+    tree decomposition and write it to <stream>
+    in <format> (see tdwriter.h), bag by bag.
     Assumes the elimination ordering was
     calculated prior.
+    ATTENTION: this function alters the graph.
+    return 1 on success, 0 otherwise
 */
-void graph_eo_to_treedecomp (Graph g);
+char graph_eo_to_treedecomp (Graph g, FILE *stream, td_format format);
+
+/* Write the tree decomposition of the ordering computed by the
+    last graph_order_* call on g, like graph_eo_to_treedecomp but
+    without eliminating the vertices a second time: the orderings
+    keep the neighbourhoods of the eliminated vertices (MCS does
+    not eliminate, its vertices are eliminated here once).
+    return 1 on success, 0 otherwise (also if there is no ordering)
+*/
+char graph_write_treedecomp (Graph g, FILE *stream, td_format format);
+
+/* Rearrange the ordering of the last graph_order_* call on g so
+    that the <count> vertices of <clique>, which have to form a
+    clique in g, are eliminated last (in the order listed), without
+    raising the width. The result is written to <ordering> (one
+    entry per vertex), the ordering of g stays as it is. Nothing is
+    eliminated: an ordering that did not eliminate the vertices (MCS,
+    AMD) is rearranged along its elimination tree in O(m alpha(m, n)),
+    which needs g unchanged like graph_ordering_width.
+    return 1 on success, 0 otherwise */
+char graph_ordering_clique_last (Graph g, const int *clique, int count, int *ordering);
+
+/* Compute the width of the ordering of g without eliminating,
+    from the elimination tree of the ordering in O(m alpha(m, n)).
+    The graph has to be unchanged (no vertex deleted or eliminated).
+    return the width, or -1 if that is not possible
+*/
+int graph_ordering_width (Graph g);
+
+/* Same as graph_ordering_width, and if <columns> is not NULL
+    also write the number of later neighbours the vertex at
+    position k of the ordering has upon elimination (the size of
+    its bag minus one) to columns[k]. */
+int graph_ordering_columns (Graph g, int *columns);
+
+/* Replace the ordering of g by <ordering>, which lists
+    every vertex of g once, dropping the eliminated graph of the
+    previous one (graph_write_treedecomp eliminates again). */
+void graph_set_ordering (Graph g, const int *ordering);
+
+/* copy the ordering of g to <ordering> */
+void graph_get_ordering (Graph g, int *ordering);
 
 /* return 1 if every node appears exactly
    once in the ordering of g
@@ -69,4 +270,6 @@ void graph_print(Graph g, FILE *stream);
 /* Print the elimination ordering of a graph
     if it has been calculated already
 */
-void graph_print_ordering(Graph g, FILE *stream);
\ No newline at end of file
+void graph_print_ordering(Graph g, FILE *stream);
+
+#endif
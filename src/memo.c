@@ -0,0 +1,239 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "memo.h"
+
+/* locks shared by the buckets, bucket b uses lock b % MEMO_LOCKS */
+#define MEMO_LOCKS 1024
+
+/* bits set per key in the filter word of its bucket */
+#define MEMO_BLOOM_PROBES 3
+
+struct memo_table
+{
+    int words;
+    size_t buckets;        /* a power of two */
+    uint64_t *keys;        /* <words> words per slot */
+    uint64_t *fingerprints; /* 0 for an empty slot */
+    int *widths;
+    unsigned char *used;   /* reference bits of the clock */
+    unsigned char *hands;  /* one per bucket */
+    int locks;
+    pthread_mutex_t *lock;
+    _Atomic uint64_t *bloom; /* a word per bucket, NULL without a filter */
+    atomic_llong entries;
+    atomic_llong evictions;
+    atomic_llong filtered;
+};
+
+/* never 0, which marks empty slots */
+static uint64_t memo_fingerprint(const uint64_t *key, int words)
+{
+    uint64_t h = 0x9e3779b97f4a7c15ULL;
+    for (int i = 0; i < words; i++)
+    {
+        h ^= key[i];
+        h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 31;
+    }
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 29;
+    return h | 1;
+}
+
+/* The filter bits of a key, 6 bits of the fingerprint each above
+    the lowest one (always set), the bucket uses the upper half. */
+static uint64_t memo_bloom_bits(uint64_t fingerprint)
+{
+    uint64_t bits = 0;
+    for (int p = 0; p < MEMO_BLOOM_PROBES; p++)
+        bits |= 1ULL << (fingerprint >> (1 + 6 * p) & 63);
+    return bits;
+}
+
+static char memo_bloom_has(struct memo_table *table, size_t bucket, uint64_t fingerprint)
+{
+    uint64_t bits = memo_bloom_bits(fingerprint);
+    return (atomic_load_explicit(&table->bloom[bucket], memory_order_relaxed) & bits) == bits;
+}
+
+/* Rebuild the word of <bucket> from the fingerprints of its slots
+    after one was replaced, so evicted keys leave the filter and it
+    does not fill up while the clock cycles through the table. Under
+    the lock of the bucket, readers see the old or the new word, both
+    hold the keys stored. */
+static void memo_bloom_rebuild(struct memo_table *table, size_t bucket)
+{
+    uint64_t word = 0;
+    for (size_t s = bucket * MEMO_WAYS; s < (bucket + 1) * MEMO_WAYS; s++)
+    {
+        if (table->fingerprints[s])
+            word |= memo_bloom_bits(table->fingerprints[s]);
+    }
+    atomic_store_explicit(&table->bloom[bucket], word, memory_order_relaxed);
+}
+
+struct memo_table *memo_table_create(int words, size_t memory, char bloom)
+{
+    size_t slot = sizeof(uint64_t) * (words + 1) + sizeof(int) + 1;
+    size_t bucket = slot * MEMO_WAYS + 1;
+    if (bloom)
+        bucket += sizeof(uint64_t);
+    if (memory < bucket)
+        return NULL;
+    size_t buckets = 1;
+    while (buckets * 2 * bucket <= memory)
+        buckets *= 2;
+
+    struct memo_table *table = (struct memo_table *)calloc(1, sizeof(struct memo_table));
+    if (!table)
+        return NULL;
+    size_t slots = buckets * MEMO_WAYS;
+    table->words = words;
+    table->buckets = buckets;
+    /* zeroed pages are only touched once used */
+    table->keys = (uint64_t *)malloc(sizeof(uint64_t) * words * slots);
+    table->fingerprints = (uint64_t *)calloc(slots, sizeof(uint64_t));
+    table->widths = (int *)malloc(sizeof(int) * slots);
+    table->used = (unsigned char *)calloc(slots, 1);
+    table->hands = (unsigned char *)calloc(buckets, 1);
+    table->locks = buckets < MEMO_LOCKS ? (int)buckets : MEMO_LOCKS;
+    table->lock = (pthread_mutex_t *)malloc(sizeof(pthread_mutex_t) * table->locks);
+    if (bloom)
+        table->bloom = (_Atomic uint64_t *)calloc(buckets, sizeof(uint64_t));
+    if (!table->keys || !table->fingerprints || !table->widths || !table->used ||
+        !table->hands || !table->lock || (bloom && !table->bloom))
+    {
+        free(table->lock);
+        table->lock = NULL;
+        table->locks = 0;
+        memo_table_destroy(table);
+        return NULL;
+    }
+    for (int i = 0; i < table->locks; i++)
+        pthread_mutex_init(&table->lock[i], NULL);
+    atomic_init(&table->entries, 0);
+    atomic_init(&table->evictions, 0);
+    atomic_init(&table->filtered, 0);
+    return table;
+}
+
+/* return the slot of <key> in its bucket, -1 if it is not there */
+static long memo_find(struct memo_table *table, size_t first, uint64_t fingerprint, const uint64_t *key)
+{
+    for (size_t s = first; s < first + MEMO_WAYS; s++)
+    {
+        if (table->fingerprints[s] == fingerprint &&
+            memcmp(table->keys + s * table->words, key, sizeof(uint64_t) * table->words) == 0)
+            return (long)s;
+    }
+    return -1;
+}
+
+char memo_table_visit(struct memo_table *table, const uint64_t *key, int width)
+{
+    uint64_t fingerprint = memo_fingerprint(key, table->words);
+    size_t bucket = (fingerprint >> 32) & (table->buckets - 1);
+    size_t first = bucket * MEMO_WAYS;
+    pthread_mutex_t *lock = &table->lock[bucket % table->locks];
+    /* probed before the lock, and a negative answer again under it:
+        the bits of a key are set under the lock of its bucket, so a
+        key stored meanwhile is not stored twice */
+    char known = !table->bloom || memo_bloom_has(table, bucket, fingerprint);
+    pthread_mutex_lock(lock);
+    if (!known)
+        known = memo_bloom_has(table, bucket, fingerprint);
+    if (!known)
+        atomic_fetch_add_explicit(&table->filtered, 1, memory_order_relaxed);
+    long found = known ? memo_find(table, first, fingerprint, key) : -1;
+    if (found >= 0)
+    {
+        table->used[found] = 1;
+        char dominated = table->widths[found] <= width;
+        if (!dominated)
+            table->widths[found] = width;
+        pthread_mutex_unlock(lock);
+        return dominated;
+    }
+    /* an empty slot, or the first one the clock finds unused */
+    long slot = -1;
+    char evicted = 0;
+    for (size_t s = first; s < first + MEMO_WAYS && slot < 0; s++)
+    {
+        if (table->fingerprints[s] == 0)
+            slot = (long)s;
+    }
+    if (slot < 0)
+    {
+        unsigned char hand = table->hands[bucket];
+        while (table->used[first + hand])
+        {
+            table->used[first + hand] = 0;
+            hand = (hand + 1) % MEMO_WAYS;
+        }
+        slot = (long)(first + hand);
+        table->hands[bucket] = (hand + 1) % MEMO_WAYS;
+        evicted = 1;
+        atomic_fetch_add_explicit(&table->evictions, 1, memory_order_relaxed);
+    }
+    else
+        atomic_fetch_add_explicit(&table->entries, 1, memory_order_relaxed);
+    memcpy(table->keys + slot * table->words, key, sizeof(uint64_t) * table->words);
+    table->fingerprints[slot] = fingerprint;
+    table->widths[slot] = width;
+    table->used[slot] = 1;
+    if (table->bloom && evicted)
+        memo_bloom_rebuild(table, bucket);
+    else if (table->bloom)
+        atomic_fetch_or_explicit(&table->bloom[bucket], memo_bloom_bits(fingerprint), memory_order_relaxed);
+    pthread_mutex_unlock(lock);
+    return 0;
+}
+
+int memo_table_lookup(struct memo_table *table, const uint64_t *key)
+{
+    uint64_t fingerprint = memo_fingerprint(key, table->words);
+    size_t bucket = (fingerprint >> 32) & (table->buckets - 1);
+    if (table->bloom && !memo_bloom_has(table, bucket, fingerprint))
+    {
+        atomic_fetch_add_explicit(&table->filtered, 1, memory_order_relaxed);
+        return -1;
+    }
+    pthread_mutex_t *lock = &table->lock[bucket % table->locks];
+    pthread_mutex_lock(lock);
+    long found = memo_find(table, bucket * MEMO_WAYS, fingerprint, key);
+    int width = -1;
+    if (found >= 0)
+    {
+        table->used[found] = 1;
+        width = table->widths[found];
+    }
+    pthread_mutex_unlock(lock);
+    return width;
+}
+
+void memo_table_stats(struct memo_table *table, struct memo_stats *stats)
+{
+    stats->entries = atomic_load(&table->entries);
+    stats->evictions = atomic_load(&table->evictions);
+    stats->filtered = atomic_load(&table->filtered);
+    stats->capacity = table->buckets * MEMO_WAYS;
+}
+
+void memo_table_destroy(struct memo_table *table)
+{
+    if (!table)
+        return;
+    for (int i = 0; i < table->locks; i++)
+        pthread_mutex_destroy(&table->lock[i]);
+    free(table->lock);
+    free(table->keys);
+    free(table->fingerprints);
+    free(table->widths);
+    free(table->used);
+    free(table->hands);
+    free((void *)table->bloom);
+    free(table);
+}
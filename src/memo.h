@@ -0,0 +1,57 @@
+/* Concurrent hash table from sets of vertices to the best width known
+    for them, e.g. the sets of eliminated vertices of a search over
+    elimination orderings. A set is a bit vector of a fixed number of
+    64 bit words (bit i of the set is bit i%64 of word i/64, like the
+    rows of bitset.h).
+    The table never grows: it is a set associative cache of buckets
+    of MEMO_WAYS slots sized to a memory cap. Every key has a 64 bit
+    fingerprint that picks its bucket and is compared before the key
+    itself. When a bucket is full, the clock algorithm evicts a slot
+    that was not used since the hand of the bucket passed it last.
+    Losing an entry only means that its state is searched again.
+    Buckets are protected by a fixed number of striped locks, so any
+    number of threads can use the table at once. An optional Bloom
+    filter of one 64 bit word per bucket answers most lookups of sets
+    that were never stored without taking a lock, and spares visits
+    of such sets the search of the bucket (storing them takes the
+    lock). The word of a bucket is rebuilt from the fingerprints of
+    its slots when one is evicted, so the filter never fills up.
+*/
+#ifndef MEMO_H
+#define MEMO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* slots per bucket */
+#define MEMO_WAYS 8
+
+struct memo_table;
+
+struct memo_stats
+{
+    long long entries;   /* sets in the table */
+    long long evictions;
+    long long filtered;  /* lookups and visits answered by the Bloom filter */
+    size_t capacity;     /* slots */
+};
+
+/* Create a table for sets of <words> words using at most <memory>
+    bytes, with a Bloom filter if <bloom> is set.
+    return NULL if <memory> does not hold a single bucket or there
+    was not enough memory */
+struct memo_table *memo_table_create(int words, size_t memory, char bloom);
+
+/* Return 1 if <key> is stored with a width of at most <width>.
+    Otherwise store <width> for <key> (replacing a larger one, or
+    evicting another set) and return 0. */
+char memo_table_visit(struct memo_table *table, const uint64_t *key, int width);
+
+/* return the width stored for <key>, -1 if it is not in the table */
+int memo_table_lookup(struct memo_table *table, const uint64_t *key);
+
+void memo_table_stats(struct memo_table *table, struct memo_stats *stats);
+
+void memo_table_destroy(struct memo_table *table);
+
+#endif
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "multistart.h"
+
+/* the runs shared by the threads */
+struct multistart_job
+{
+    Graph g;
+    strategy heuristic;
+    mcs_tie tie;
+    uint64_t seed;
+    int lower_bound;       /* no run can beat a width of this */
+    struct multistart_result *result;
+    atomic_int next_run;
+    atomic_int bound;      /* best width so far, for stopping runs */
+    pthread_mutex_t lock;  /* protects best, best_width and best_run */
+};
+
+/* do runs until none are left */
+static void *multistart_worker(void *arg)
+{
+    struct multistart_job *job = (struct multistart_job *)arg;
+    struct multistart_result *result = job->result;
+    int run;
+    while ((run = atomic_fetch_add(&job->next_run, 1)) < result->runs)
+    {
+        if (atomic_load(&job->bound) <= job->lower_bound)
+        {
+            result->widths[run] = MULTISTART_SKIPPED;
+            continue;
+        }
+        Graph clone = graph_clone(job->g);
+        if (clone == NULL)
+        {
+            result->widths[run] = -1;
+            continue;
+        }
+        if (run > 0)
+            graph_set_random_ties(clone, job->seed + run);
+        graph_set_width_bound(clone, &job->bound);
+        int width = graph_order(clone, job->heuristic, job->tie);
+        result->widths[run] = width;
+        if (width < 0)
+        {
+            graph_destroy(clone);
+            continue;
+        }
+
+        int bound = atomic_load(&job->bound);
+        while (width < bound && !atomic_compare_exchange_weak(&job->bound, &bound, width))
+            ;
+        pthread_mutex_lock(&job->lock);
+        if (result->best == NULL || width < result->best_width ||
+            (width == result->best_width && run < result->best_run))
+        {
+            Graph previous = result->best;
+            result->best = clone;
+            result->best_width = width;
+            result->best_run = run;
+            clone = previous;
+        }
+        pthread_mutex_unlock(&job->lock);
+        if (clone)
+            graph_destroy(clone);
+    }
+    return NULL;
+}
+
+char multistart_order(Graph g, strategy heuristic, mcs_tie tie, int runs,
+                      int threads, uint64_t seed, int lower_bound,
+                      struct multistart_result *result)
+{
+    result->best = NULL;
+    result->best_width = -1;
+    result->best_run = -1;
+    result->runs = runs;
+    result->widths = (int *)malloc(sizeof(int) * (runs > 0 ? runs : 1));
+    if (!result->widths)
+        return 0;
+
+    struct multistart_job job;
+    job.g = g;
+    job.heuristic = heuristic;
+    job.tie = tie;
+    job.seed = seed;
+    job.lower_bound = lower_bound;
+    job.result = result;
+    atomic_init(&job.next_run, 0);
+    atomic_init(&job.bound, INT_MAX);
+    pthread_mutex_init(&job.lock, NULL);
+
+    if (threads > runs)
+        threads = runs;
+    pthread_t *workers = threads > 1 ? (pthread_t *)malloc(sizeof(pthread_t) * threads) : NULL;
+    int started = 0;
+    for (; workers && started < threads - 1; started++)
+    {
+        if (pthread_create(&workers[started], NULL, multistart_worker, &job) != 0)
+            break; /* the others take over its runs */
+    }
+    multistart_worker(&job);
+    for (int i = 0; i < started; i++)
+        pthread_join(workers[i], NULL);
+    free(workers);
+    pthread_mutex_destroy(&job.lock);
+    return result->best != NULL;
+}
+
+static int compare_width(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+void multistart_print_widths(const struct multistart_result *result, FILE *stream)
+{
+    int *sorted = (int *)malloc(sizeof(int) * (result->runs > 0 ? result->runs : 1));
+    if (!sorted)
+        return;
+    int count = 0, cut = 0, skipped = 0, failed = 0;
+    for (int i = 0; i < result->runs; i++)
+    {
+        if (result->widths[i] >= 0)
+            sorted[count++] = result->widths[i];
+        else if (result->widths[i] == ORDER_CUTOFF)
+            cut++;
+        else if (result->widths[i] == MULTISTART_SKIPPED)
+            skipped++;
+        else
+            failed++;
+    }
+    qsort(sorted, count, sizeof(int), compare_width);
+    for (int i = 0; i < count;)
+    {
+        int j = i;
+        while (j < count && sorted[j] == sorted[i])
+            j++;
+        fprintf(stream, "%s%d: %d", i > 0 ? ", " : "", sorted[i], j - i);
+        i = j;
+    }
+    if (cut > 0)
+        fprintf(stream, "%sstopped early: %d", count > 0 ? ", " : "", cut);
+    if (skipped > 0)
+        fprintf(stream, "%sskipped at the lower bound: %d", count + cut > 0 ? ", " : "", skipped);
+    if (failed > 0)
+        fprintf(stream, "%sfailed: %d", count + cut + skipped > 0 ? ", " : "", failed);
+    fprintf(stream, "\n");
+    free(sorted);
+}
+
+void multistart_result_free(struct multistart_result *result)
+{
+    if (result->best)
+        graph_destroy(result->best);
+    result->best = NULL;
+    free(result->widths);
+    result->widths = NULL;
+}
@@ -0,0 +1,47 @@
+/* Multi-start orderings: the same heuristic is run several times
+    with random tie breaking (see graph_set_random_ties), each run on
+    its own clone of the graph, and the ordering of smallest width is
+    kept. Run 0 breaks ties as usual, so the result is never worse
+    than a single run. Run i uses the seed <seed> + i, which makes
+    the result reproducible for any number of threads: the best width
+    and the first run reaching it do not depend on the scheduling.
+    Min-Degree and Min-Fill-in runs stop as soon as their width
+    exceeds the best one found so far, and no further runs are
+    started once the best width reaches a known lower bound.
+*/
+#ifndef MULTISTART_H
+#define MULTISTART_H
+
+#include <stdint.h>
+
+#include "graph.h"
+
+/* width of a run that was not started since the
+    lower bound was reached already */
+#define MULTISTART_SKIPPED -3
+
+struct multistart_result
+{
+    Graph best;     /* clone ordered by the best run, NULL if every run failed */
+    int best_width;
+    int best_run;
+    int runs;
+    int *widths;    /* of every run, ORDER_CUTOFF if stopped, -1 if failed,
+                       MULTISTART_SKIPPED if not started */
+};
+
+/* order <runs> clones of g with <heuristic> (MCS ties by <tie>) using
+    <threads> threads and fill in <result>, skipping the remaining runs
+    once a width equals <lower_bound> (-1 if unknown).
+    g has to outlive result->best.
+    return 1 on success, 0 if no run succeeded */
+char multistart_order(Graph g, strategy heuristic, mcs_tie tie, int runs,
+                      int threads, uint64_t seed, int lower_bound,
+                      struct multistart_result *result);
+
+/* print the widths of the runs as "<width>: <count>" pairs */
+void multistart_print_widths(const struct multistart_result *result, FILE *stream);
+
+void multistart_result_free(struct multistart_result *result);
+
+#endif
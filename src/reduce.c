@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "reduce.h"
+
+const char *REDUCTION_RULE_NAMES[REDUCTION_RULES] = {
+    "islet", "twig", "series", "triangle", "buddy", "simplicial", "almost simplicial"};
+
+/* state of a reduction run */
+struct reducer
+{
+    Graph g;              /* the clone that is reduced */
+    struct reduction *r;
+    int *queue;           /* worklist, a ring of n entries */
+    char *queued;         /* 1 if the vertex is in the worklist */
+    int head;
+    int size;
+    int *neighbours;      /* scratch lists of n entries */
+    int *missing;
+    int *other;
+};
+
+/* check <vertex> again later, unless it is queued or gone */
+static void reducer_push(struct reducer *rd, int vertex)
+{
+    if (rd->queued[vertex] || graph_degree(rd->g, vertex) < 0)
+        return;
+    rd->queued[vertex] = 1;
+    rd->queue[(rd->head + rd->size++) % rd->r->n] = vertex;
+}
+
+static int reducer_pop(struct reducer *rd)
+{
+    int vertex = rd->queue[rd->head];
+    rd->head = (rd->head + 1) % rd->r->n;
+    rd->size--;
+    rd->queued[vertex] = 0;
+    return vertex;
+}
+
+/* Eliminate <vertex> by <rule> and queue its neighbours. If the
+    elimination adds edges (<fill>), vertices adjacent to both ends
+    of a new edge may have become simplicial, so the neighbours of
+    the neighbours are queued as well. */
+static void reducer_eliminate(struct reducer *rd, int vertex, enum reduction_rule rule, char fill)
+{
+    struct reduction *r = rd->r;
+    int degree = graph_eliminate_vertex(rd->g, vertex, rd->neighbours);
+    r->prefix[r->prefix_len++] = vertex;
+    r->rules[rule]++;
+    if (degree > r->width)
+        r->width = degree;
+    for (int i = 0; i < degree; i++)
+    {
+        int neighbour = rd->neighbours[i];
+        reducer_push(rd, neighbour);
+        if (!fill)
+            continue;
+        int len = graph_neighbours(rd->g, neighbour, rd->other);
+        for (int j = 0; j < len; j++)
+            reducer_push(rd, rd->other[j]);
+    }
+}
+
+/* Write the neighbours of <vertex> to rd->neighbours and find out
+    if it is simplicial (return 0) or almost simplicial (return 1,
+    the neighbour that is not part of the clique is in *<center>),
+    return -1 otherwise. With <simplicial_only> the search stops at
+    the first missing edge.
+    For every neighbour the number of other neighbours it is not
+    adjacent to is counted; their sum counts every missing edge
+    twice. All missing edges have an end in <center> exactly if
+    the sum is twice the count of <center>. */
+static int reducer_classify(struct reducer *rd, int vertex, char simplicial_only, int *center)
+{
+    int degree = graph_neighbours(rd->g, vertex, rd->neighbours);
+    long total = 0;
+    int widest = -1;
+    for (int i = 0; i < degree; i++)
+    {
+        int missing = degree - 1 - graph_common_neighbours(rd->g, vertex, rd->neighbours[i]);
+        if (missing > 0 && simplicial_only)
+            return -1;
+        /* two neighbours missing more than one edge each */
+        if (missing > 1 && widest >= 0 && rd->missing[widest] > 1)
+            return -1;
+        rd->missing[i] = missing;
+        total += missing;
+        if (widest < 0 || missing > rd->missing[widest])
+            widest = i;
+    }
+    if (total == 0)
+        return 0;
+    if (total != 2L * rd->missing[widest])
+        return -1;
+    *center = rd->neighbours[widest];
+    return 1;
+}
+
+/* return a vertex of degree 3 with the same neighbours as <vertex>
+    (listed in rd->neighbours), -1 if there is none */
+static int reducer_buddy(struct reducer *rd, int vertex)
+{
+    int *neighbours = rd->neighbours;
+    int len = graph_neighbours(rd->g, neighbours[0], rd->other);
+    for (int i = 0; i < len; i++)
+    {
+        int other = rd->other[i];
+        if (other != vertex && graph_degree(rd->g, other) == 3 &&
+            graph_has_edge(rd->g, other, neighbours[1]) &&
+            graph_has_edge(rd->g, other, neighbours[2]))
+            return other;
+    }
+    return -1;
+}
+
+/* apply the first rule that fits <vertex> */
+static void reducer_check(struct reducer *rd, int vertex)
+{
+    struct reduction *r = rd->r;
+    int degree = graph_degree(rd->g, vertex);
+    if (degree < 0)
+        return;
+    if (degree <= 1)
+    {
+        if (degree > r->low)
+            r->low = degree;
+        reducer_eliminate(rd, vertex, degree == 0 ? rule_islet : rule_twig, 0);
+        return;
+    }
+    int center;
+    int kind = reducer_classify(rd, vertex, degree > r->low, &center);
+    if (kind == 0)
+    {
+        /* the vertex and its neighbours form a clique */
+        if (degree > r->low)
+            r->low = degree;
+        reducer_eliminate(rd, vertex, rule_simplicial, 0);
+    }
+    else if (kind == 1)
+    {
+        enum reduction_rule rule = rule_almost_simplicial;
+        if (degree == 2)
+            rule = rule_series;
+        else if (degree == 3)
+            rule = rule_triangle;
+        reducer_eliminate(rd, vertex, rule, 1);
+    }
+    else if (degree == 3 && r->low >= 3)
+    {
+        int buddy = reducer_buddy(rd, vertex);
+        if (buddy < 0)
+            return;
+        /* afterwards the buddy is simplicial */
+        reducer_eliminate(rd, vertex, rule_buddy, 1);
+        reducer_eliminate(rd, buddy, rule_buddy, 0);
+    }
+}
+
+char reduction_run(Graph g, int low, struct reduction *r)
+{
+    int n = graph_vertex_count(g);
+    memset(r, 0, sizeof(struct reduction));
+    r->n = n;
+    r->low = low > 0 ? low : 0;
+    r->prefix = (int *)malloc(sizeof(int) * (n + 1));
+    r->label = (int *)malloc(sizeof(int) * (n + 1));
+    struct reducer rd;
+    rd.g = graph_clone(g);
+    rd.r = r;
+    rd.queue = (int *)malloc(sizeof(int) * (n + 1));
+    rd.queued = (char *)calloc(n + 1, 1);
+    rd.neighbours = (int *)malloc(sizeof(int) * (n + 1));
+    rd.missing = (int *)malloc(sizeof(int) * (n + 1));
+    rd.other = (int *)malloc(sizeof(int) * (n + 1));
+    rd.head = rd.size = 0;
+    char ok = r->prefix && r->label && rd.g && rd.queue && rd.queued &&
+              rd.neighbours && rd.missing && rd.other;
+    if (ok)
+    {
+        for (int v = 0; v < n; v++)
+            reducer_push(&rd, v);
+        while (rd.size > 0)
+            reducer_check(&rd, reducer_pop(&rd));
+
+        for (int v = 0; v < n; v++)
+        {
+            if (graph_degree(rd.g, v) >= 0)
+                r->label[r->kernel_n++] = v;
+        }
+        r->kernel = graph_induced(rd.g, r->label, r->kernel_n, NULL);
+        ok = r->kernel != NULL;
+    }
+    graph_destroy(rd.g);
+    free(rd.queue);
+    free(rd.queued);
+    free(rd.neighbours);
+    free(rd.missing);
+    free(rd.other);
+    if (!ok)
+        reduction_free(r);
+    return ok;
+}
+
+void reduction_expand(const struct reduction *r, const int *kernel_ordering, int *ordering)
+{
+    memcpy(ordering, r->prefix, sizeof(int) * r->prefix_len);
+    for (int k = 0; k < r->kernel_n; k++)
+        ordering[r->prefix_len + k] = r->label[kernel_ordering[k]];
+}
+
+void reduction_print_rules(const struct reduction *r, FILE *stream)
+{
+    int printed = 0;
+    for (int i = 0; i < REDUCTION_RULES; i++)
+    {
+        if (r->rules[i] == 0)
+            continue;
+        fprintf(stream, "%s%s: %d", printed++ ? ", " : "", REDUCTION_RULE_NAMES[i], r->rules[i]);
+    }
+    fprintf(stream, "%s\n", printed ? "" : "none");
+}
+
+void reduction_free(struct reduction *r)
+{
+    graph_destroy(r->kernel);
+    r->kernel = NULL;
+    free(r->prefix);
+    r->prefix = NULL;
+    free(r->label);
+    r->label = NULL;
+}
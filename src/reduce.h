@@ -0,0 +1,68 @@
+/* Safe reduction rules (Bodlaender and Koster) applied before
+    ordering. A vertex is eliminated right away if this can not
+    raise the treewidth above a known lower bound <low>:
+    islet, twig:      vertices of degree 0 and 1
+    simplicial:       the neighbours form a clique, low is raised
+                      to the degree
+    series, triangle: vertices of degree 2 and 3 (if low is at
+                      least 2 and 3) that are almost simplicial
+    buddy:            two vertices of degree 3 with the same
+                      neighbours, if low is at least 3
+    almost simplicial: all neighbours but one form a clique and
+                      the degree is at most low
+    The treewidth of the graph is the larger one of low and the
+    treewidth of the remaining kernel, so only the kernel needs to
+    be ordered. Vertices are checked again from a worklist whenever
+    their neighbourhood changed.
+*/
+#ifndef REDUCE_H
+#define REDUCE_H
+
+#include <stdio.h>
+
+#include "graph.h"
+
+enum reduction_rule
+{
+    rule_islet,
+    rule_twig,
+    rule_series,
+    rule_triangle,
+    rule_buddy,
+    rule_simplicial,
+    rule_almost_simplicial,
+    REDUCTION_RULES /* number of rules */
+};
+
+/* names of the rules, for printing */
+extern const char *REDUCTION_RULE_NAMES[REDUCTION_RULES];
+
+struct reduction
+{
+    Graph kernel;   /* the vertices left, possibly none */
+    int *label;     /* vertex k of the kernel is vertex label[k] of the graph */
+    int kernel_n;
+    int *prefix;    /* the eliminated vertices in the order of elimination */
+    int prefix_len;
+    int n;          /* vertices of the graph */
+    int width;      /* largest degree of a prefix vertex upon elimination */
+    int low;        /* lower bound of the treewidth of the graph */
+    int rules[REDUCTION_RULES]; /* vertices eliminated by each rule */
+};
+
+/* Reduce a clone of g, which has to be unchanged (not ordered
+    before), starting from the lower bound <low> of its treewidth
+    (see graph_lower_bound). The kernel has the representation of g.
+    return 1 on success, 0 if there was not enough memory */
+char reduction_run(Graph g, int low, struct reduction *r);
+
+/* write the ordering of the graph that eliminates the prefix and
+    then the kernel in <kernel_ordering> to <ordering> (r->n entries) */
+void reduction_expand(const struct reduction *r, const int *kernel_ordering, int *ordering);
+
+/* print the number of vertices each rule eliminated */
+void reduction_print_rules(const struct reduction *r, FILE *stream);
+
+void reduction_free(struct reduction *r);
+
+#endif
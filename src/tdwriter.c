@@ -0,0 +1,209 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "tdwriter.h"
+
+/* size of the output buffer */
+#define TD_BUFFER_SIZE (1 << 20)
+/* room for the longest item written at once, an int with separators */
+#define TD_ITEM_MAX 32
+
+#define TD_BINARY_MAGIC "TDBAGS\n\032"
+#define TD_BINARY_VERSION 1
+#define TD_BYTE_ORDER 0x01020304u
+
+struct td_writer
+{
+    FILE *stream;
+    td_format format;
+    int bags;
+    char failed; /* a write to <stream> failed */
+    size_t used;
+    char buffer[TD_BUFFER_SIZE];
+};
+
+/* the decimal digits of 00 to 99 */
+static const char DIGIT_PAIRS[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static void td_flush(struct td_writer *w)
+{
+    if (w->used && fwrite(w->buffer, 1, w->used, w->stream) != w->used)
+        w->failed = 1;
+    w->used = 0;
+}
+
+/* make sure <bytes> more bytes fit into the buffer */
+static inline void td_reserve(struct td_writer *w, size_t bytes)
+{
+    if (w->used + bytes > TD_BUFFER_SIZE)
+        td_flush(w);
+}
+
+static inline void td_put_char(struct td_writer *w, char c)
+{
+    td_reserve(w, 1);
+    w->buffer[w->used++] = c;
+}
+
+static void td_put_string(struct td_writer *w, const char *s)
+{
+    size_t len = strlen(s);
+    td_reserve(w, len);
+    memcpy(w->buffer + w->used, s, len);
+    w->used += len;
+}
+
+/* write <value> in decimal, two digits at a time */
+static inline void td_put_uint(struct td_writer *w, unsigned value)
+{
+    char digits[10];
+    int pos = sizeof(digits);
+    while (value >= 100)
+    {
+        unsigned pair = value % 100 * 2;
+        value /= 100;
+        digits[--pos] = DIGIT_PAIRS[pair + 1];
+        digits[--pos] = DIGIT_PAIRS[pair];
+    }
+    if (value >= 10)
+    {
+        digits[--pos] = DIGIT_PAIRS[value * 2 + 1];
+        digits[--pos] = DIGIT_PAIRS[value * 2];
+    }
+    else
+        digits[--pos] = '0' + value;
+    td_reserve(w, TD_ITEM_MAX);
+    memcpy(w->buffer + w->used, digits + pos, sizeof(digits) - pos);
+    w->used += sizeof(digits) - pos;
+}
+
+static inline void td_put_u32(struct td_writer *w, uint32_t value)
+{
+    td_reserve(w, sizeof(value));
+    memcpy(w->buffer + w->used, &value, sizeof(value));
+    w->used += sizeof(value);
+}
+
+struct td_writer *td_writer_open(FILE *stream, td_format format,
+                                 int bags, int max_bag, int vertices)
+{
+    struct td_writer *w = malloc(sizeof(struct td_writer));
+    if (!w)
+        return NULL;
+    w->stream = stream;
+    w->format = format;
+    w->bags = bags;
+    w->failed = 0;
+    w->used = 0;
+    if (format == td_format_pace)
+    {
+        td_put_string(w, "s td ");
+        td_put_uint(w, bags);
+        td_put_char(w, ' ');
+        td_put_uint(w, max_bag);
+        td_put_char(w, ' ');
+        td_put_uint(w, vertices);
+        td_put_char(w, '\n');
+    }
+    else if (format == td_format_binary)
+    {
+        td_reserve(w, 8);
+        memcpy(w->buffer, TD_BINARY_MAGIC, 8);
+        w->used = 8;
+        td_put_u32(w, TD_BINARY_VERSION);
+        td_put_u32(w, TD_BYTE_ORDER);
+        td_put_u32(w, bags);
+        td_put_u32(w, vertices);
+        td_put_u32(w, max_bag);
+    }
+    return w;
+}
+
+void td_writer_bag(struct td_writer *w, int index, const int *bag, int size)
+{
+    switch (w->format)
+    {
+    case td_format_pace:
+        td_put_string(w, "b ");
+        td_put_uint(w, index + 1);
+        for (int i = 0; i < size; i++)
+        {
+            td_put_char(w, ' ');
+            td_put_uint(w, bag[i] + 1);
+        }
+        td_put_char(w, '\n');
+        break;
+    case td_format_binary:
+        td_put_u32(w, size);
+        for (int i = 0; i < size; i++)
+            td_put_u32(w, bag[i]);
+        break;
+    default:
+        td_put_char(w, 'N');
+        td_put_uint(w, index);
+        td_put_string(w, ",,");
+        for (int i = 0; i < size; i++)
+        {
+            if (i > 0)
+                td_put_char(w, ';');
+            td_put_uint(w, bag[i]);
+        }
+        td_put_char(w, '\n');
+        break;
+    }
+}
+
+void td_writer_tree(struct td_writer *w, const int *parent)
+{
+    int first_root = -1;
+    for (int i = 0; i < w->bags; i++)
+    {
+        int p = parent[i];
+        if (w->format == td_format_binary)
+        {
+            td_put_u32(w, (uint32_t)p);
+            continue;
+        }
+        if (p < 0 && w->format == td_format_pace)
+        {
+            /* the parts of a forest have no vertices in common,
+                any bag can connect them */
+            if (first_root < 0)
+            {
+                first_root = i;
+                continue;
+            }
+            p = first_root;
+        }
+        if (p < 0)
+            continue;
+        int a = p < i ? p : i, b = p < i ? i : p;
+        if (w->format == td_format_pace)
+        {
+            td_put_uint(w, a + 1);
+            td_put_char(w, ' ');
+            td_put_uint(w, b + 1);
+            td_put_char(w, '\n');
+        }
+        else
+        {
+            td_put_char(w, 'N');
+            td_put_uint(w, a);
+            td_put_string(w, ",N");
+            td_put_uint(w, b);
+            td_put_string(w, ",\n");
+        }
+    }
+}
+
+char td_writer_close(struct td_writer *w)
+{
+    td_flush(w);
+    char ok = !w->failed && fflush(w->stream) == 0;
+    free(w);
+    return ok;
+}
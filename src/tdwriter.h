@@ -0,0 +1,45 @@
+/* Output of tree decompositions.
+    The bags are written one by one as they are computed, through
+    a large buffer with its own integer formatting instead of a
+    printf call per number. The tree edges follow at the end.
+    Formats (see td_format in graph.h):
+    csv:    "N<bag>,,<v>;<v>;..." lines for the bags followed by
+            "N<bag>,N<bag>," lines for the edges, numbered from 0
+    pace:   the .td format of the PACE challenge, "s td <bags>
+            <max bag size> <vertices>", "b <bag> <v> <v> ..." and
+            "<bag> <bag>" edge lines, everything numbered from 1.
+            The tree has to be connected, so the roots of a forest
+            are attached to the first root.
+    binary: header (magic "TDBAGS\n\032", then uint32 version, byte
+            order mark 0x01020304, bags, vertices, max bag size),
+            per bag its uint32 size and vertices, and finally the
+            int32 parent of every bag (-1 for roots), all in the
+            byte order of the writing machine
+*/
+#ifndef TDWRITER_H
+#define TDWRITER_H
+
+#include <stdio.h>
+
+#include "graph.h"
+
+struct td_writer;
+
+/* start writing a decomposition with <bags> bags of at most
+    <max_bag> of the <vertices> vertices to <stream>.
+    return NULL if there is not enough memory */
+struct td_writer *td_writer_open(FILE *stream, td_format format,
+                                 int bags, int max_bag, int vertices);
+
+/* write bag number <index>, the bags have to be written in order */
+void td_writer_bag(struct td_writer *w, int index, const int *bag, int size);
+
+/* write the tree edges, bag i is attached to <parent[i]>
+    or is a root if that is -1 */
+void td_writer_tree(struct td_writer *w, const int *parent);
+
+/* flush and free the writer, the stream stays open.
+    return 1 if everything was written, 0 otherwise */
+char td_writer_close(struct td_writer *w);
+
+#endif
@@ -0,0 +1,124 @@
+#include <time.h>
+#include <string.h>
+
+#include "timing.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+const char *PERF_COUNTER_NAMES[PERF_COUNTERS] = {
+    "Cycles", "Instructions", "LLC misses", "Branch misses"};
+
+double timing_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#ifdef __linux__
+
+static const unsigned long long PERF_CONFIG[PERF_COUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES};
+
+int perf_counters_open(struct perf_counters *counters)
+{
+    int opened = 0;
+    for (int i = 0; i < PERF_COUNTERS; i++)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_CONFIG[i];
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        /* the counters may be multiplexed, scale them by the
+            fraction of time they were actually running */
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        /* pid 0, cpu -1: the calling thread on any cpu */
+        counters->fd[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (counters->fd[i] >= 0)
+            opened++;
+        else
+            counters->fd[i] = -1;
+    }
+    return opened;
+}
+
+void perf_counters_start(struct perf_counters *counters)
+{
+    for (int i = 0; i < PERF_COUNTERS; i++)
+    {
+        if (counters->fd[i] < 0)
+            continue;
+        ioctl(counters->fd[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(counters->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void perf_counters_stop(struct perf_counters *counters, long long *values)
+{
+    for (int i = 0; i < PERF_COUNTERS; i++)
+    {
+        values[i] = -1;
+        if (counters->fd[i] < 0)
+            continue;
+        ioctl(counters->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+        unsigned long long data[3]; /* value, time enabled, time running */
+        if (read(counters->fd[i], data, sizeof(data)) != sizeof(data))
+            continue;
+        if (data[2] == 0)
+            values[i] = 0;
+        else if (data[2] < data[1])
+            values[i] = (long long)((double)data[0] * data[1] / data[2]);
+        else
+            values[i] = (long long)data[0];
+    }
+}
+
+void perf_counters_close(struct perf_counters *counters)
+{
+    for (int i = 0; i < PERF_COUNTERS; i++)
+    {
+        if (counters->fd[i] >= 0)
+            close(counters->fd[i]);
+        counters->fd[i] = -1;
+    }
+}
+
+#else
+
+int perf_counters_open(struct perf_counters *counters)
+{
+    for (int i = 0; i < PERF_COUNTERS; i++)
+        counters->fd[i] = -1;
+    return 0;
+}
+
+void perf_counters_start(struct perf_counters *counters)
+{
+    (void)counters;
+}
+
+void perf_counters_stop(struct perf_counters *counters, long long *values)
+{
+    (void)counters;
+    for (int i = 0; i < PERF_COUNTERS; i++)
+        values[i] = -1;
+}
+
+void perf_counters_close(struct perf_counters *counters)
+{
+    (void)counters;
+}
+
+#endif
@@ -0,0 +1,44 @@
+/* Wall-clock time and hardware performance counters
+    for measuring the heuristics.
+    The counters use perf_event_open and are only available
+    on Linux, and only if the kernel allows it
+    (see /proc/sys/kernel/perf_event_paranoid).
+*/
+#ifndef TIMING_H
+#define TIMING_H
+
+/* seconds on a monotonic clock, only differences are meaningful */
+double timing_now(void);
+
+enum perf_counter
+{
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_COUNTERS /* number of counters */
+};
+
+/* names of the counters, e.g. for CSV headers */
+extern const char *PERF_COUNTER_NAMES[PERF_COUNTERS];
+
+/* counters of the calling thread */
+struct perf_counters
+{
+    int fd[PERF_COUNTERS]; /* -1 if not available */
+};
+
+/* open the counters for the calling thread, user space only.
+    return the number of counters that could be opened */
+int perf_counters_open(struct perf_counters *counters);
+
+/* reset the counters and start counting */
+void perf_counters_start(struct perf_counters *counters);
+
+/* stop counting and write the counts to <values>,
+    -1 for counters that are not available */
+void perf_counters_stop(struct perf_counters *counters, long long *values);
+
+void perf_counters_close(struct perf_counters *counters);
+
+#endif
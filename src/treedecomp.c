@@ -1,125 +1,197 @@
 #include "graph.h"
+#include "bitset.h"
+#include "timing.h"
+#include "benchmark.h"
+#include "multistart.h"
+#include "anytime.h"
+#include "reduce.h"
+#include "decompose.h"
+#include "exact.h"
 #include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <getopt.h>
 #include <time.h>
 #include <errno.h>
 #include <string.h>
+#include <sys/stat.h>
 
-#define FILENAME_MAX_LENGTH 50
-
-const char *STRATEGY[] = {"Unspecified", "Min-Degree", "Min-Fill-in-edges", "Maximum-Cardinality-Search"};
+const char *STRATEGY[] = {"Unspecified", "Min-Degree", "Min-Fill-in-edges", "Maximum-Cardinality-Search", "Approximate-Minimum-Degree"};
 
 char *optarg;
 int optind, opterr, optopt;
 
-void print_file_header(FILE *fptr)
-{
-  fprintf(fptr, "Filename,Width Min-Degree,Time Min-Degree,"
-                "Width Min-Fill-in,Time Min-Fill-in,"
-                "Width MCS,Time MCS\n");
-}
-
-int benchmark(char *name, FILE *inputfile, FILE *resultfile)
-{
-  Graph g = graph_import(inputfile);
-  if (g == NULL)
-    return 1;
-  Graph g1 = graph_copy(g);
-  Graph g2 = graph_copy(g);
-  // int n = graph_vertex_count(g);
-
-  float start, end;
-  start = clock();
-  int width_d = graph_order_degree(g);
-  end = clock();
-  float time_d = (end - start) / CLOCKS_PER_SEC;
-
-  start = clock();
-  int width_f = graph_order_fillin(g1);
-  end = clock();
-  float time_f = (end - start) / CLOCKS_PER_SEC;
-
-  start = clock();
-  int width_mcs = graph_order_mcs(g2);
-  end = clock();
-  float time_mcs = (end - start) / CLOCKS_PER_SEC;
-
-  fprintf(resultfile, "%s,%d,%f,%d,%f,%d,%f\n",
-          name, width_d, time_d, width_f, time_f,
-          width_mcs, time_mcs);
-  printf("Analyzed file %s\n", name);
-  fflush(resultfile);
-  fflush(stdout);
-  graph_destroy(g);
-  graph_destroy(g1);
-  graph_destroy(g2);
-  return 0;
-}
-
 typedef enum mode
 {
   undefined,
   eo,
   td,
-  list
+  list,
+  convert,
+  fused,
+  evaluate
 } mode;
 int main(int argc, char **argv)
 {
   char *inputpath = NULL;
-  char usagestring[] = "usage: treedecomp [-h] [-D|C|F] [-o|t|l] filepath [eo_filepath]\n\n"
+  char usagestring[] = "usage: treedecomp [-h] [-D|C|F|Q] [-c tie] [-R K] [-s seed] [--time-limit sec] [--best-file file] [-L] [-p] [-d] [-x] [--exact-time sec] [--exact-memory MB] [-M|S] [-j N] [-P] [-r K] [-w W] [-A] [-B baseline] [-T pct] [-k] [-f format] [-o|t|e|l|b] filepath [eo_filepath|output]\n\n"
                        "Calculate tree decomposition of a provided graph or graphs\n\n"
                        "options:\n"
                        "\t-h\tdisplay this message\n"
                        "\t-o\tcreate an elimination ordering (EO) of a single graph provided by <filepath>\n"
                        "\t-t\tcreate a tree decomposition from a graph provided by <filepath> and an elimination ordering provided by <eo_filepath>\n"
+                       "\t-e\tprint the width of the elimination ordering provided by <eo_filepath> for the graph provided by <filepath>\n"
+                       "\t-o -t\tcreate an elimination ordering of <filepath> and print its tree decomposition right away "
+                       "(verbose output goes to stderr)\n"
                        "\t-l\tdo a benchmark of elimination orderings of a list of graphs declared in <filepath> (results of "
                        "size and time in results.csv, no actual ordering for each graph is saved)\n"
+                       "\t-b\tconvert the graph provided by <filepath> to the binary format, written to <output> "
+                       "(default <filepath>.tdbin)\n"
+                       "\t-f\toutput format of tree decompositions: csv (default), td (PACE) or bin\n"
+                       "\t-k\tcache imported text graphs in binary format next to them (<filepath>.tdbin)\n"
+                       "\t-j\tuse N threads in benchmark mode, for the parts of -d or the search of -x, or for the initial priorities of -F with -o (default 1)\n"
+                       "\t-P\trecord hardware performance counters (cycles, instructions, cache and branch misses)\n"
+                       "\t-r\tmeasure K runs of every heuristic in benchmark mode and report their median (default 1)\n"
+                       "\t-w\tdo W discarded warmup runs before the measured ones (default 0)\n"
+                       "\t-A\tpin every benchmark thread to its own core\n"
+                       "\t-B\tcompare the median times with an earlier results file <baseline>, exit with 2 on regressions\n"
+                       "\t-T\tpercentage a time may exceed the baseline before it counts as regression (default 10), "
+                       "differences below 1 ms never count\n"
                        "\t-v\tuse verbose printing\n"
                        "\t-D\tuse the min-degree heuristic when creating an elimination ordering\n"
                        "\t-C\tuse the max-cardinality heuristic when creating an elimination ordering\n"
-                       "\t-F\tuse the min-fill-in heuristic when creating an elimination ordering\n";
+                       "\t-Q\tuse the approximate minimum degree heuristic (quotient graph, for large sparse graphs)\n"
+                       "\t-c\tbreak ties of the max-cardinality heuristic by min (default) or max degree\n"
+                       "\t-R\twith -o, run the heuristic K times with random tie breaking (in parallel with -j) and keep the best ordering\n"
+                       "\t-s\tseed of the random tie breaking of -R (default 1)\n"
+                       "\t--time-limit\twith -o, print the min-degree ordering and keep printing better ones "
+                       "(min-fill-in, random restarts, local search) until <sec> seconds have passed\n"
+                       "\t--best-file\twith --time-limit, also keep the best ordering so far in <file>\n"
+                       "\t-L\tcompute a treewidth lower bound and stop -R and --time-limit once a width reaches it "
+                       "(the bound is printed by -v and always written in benchmark mode)\n"
+                       "\t-p\teliminate vertices by safe reduction rules (simplicial, almost simplicial, degree <= 3) "
+                       "first and order only the remaining kernel, with -o and -l\n"
+                       "\t-d\twith -o, split the graph into connected components and atoms along clique separators, "
+                       "order every part on its own (in parallel with -j) and join the orderings\n"
+                       "\t-x\twith -o, search an optimal ordering by branch and bound, starting from the ordering "
+                       "of the heuristic (for small graphs or kernels of -p)\n"
+                       "\t--exact-time\tstop the search of -x after <sec> seconds with the best ordering found (default 60)\n"
+                       "\t--exact-memory\tmemory of the table of visited states of -x in MB (default 1024)\n"
+                       "\t-F\tuse the min-fill-in heuristic when creating an elimination ordering\n"
+                       "\t-M\tstore the graph as bit matrix (default for small or dense graphs)\n"
+                       "\t-S\tstore the graph as sparse neighbour lists (default for large sparse graphs)\n";
   int c;
   strategy heuristic = degree;
+  representation rep = automatic;
   mode mode = undefined;
   int verbose_printing = 0;
+  char use_counters = 0;
+  char *baseline_path = NULL;
+  struct benchmark_options bench = {automatic, 1, 1, 0, 0, 0, 0, 0, mcs_tie_min, NULL, 10};
+  char cache = 0;
+  td_format format = td_format_csv;
+  mcs_tie tie = mcs_tie_min;
+  int runs = 1;
+  uint64_t seed = 1;
+  double time_limit = 0;
+  char stop_at_bound = 0;
+  char reduce = 0;
+  char split = 0;
+  char exact = 0;
+  double exact_time = 60;
+  double exact_memory = 1024;
+  char *best_path = NULL;
+  /* long options only, their values are no option characters */
+  enum
+  {
+    option_time_limit = 256,
+    option_best_file,
+    option_exact_time,
+    option_exact_memory
+  };
+  static const struct option long_options[] = {
+      {"time-limit", required_argument, NULL, option_time_limit},
+      {"best-file", required_argument, NULL, option_best_file},
+      {"exact-time", required_argument, NULL, option_exact_time},
+      {"exact-memory", required_argument, NULL, option_exact_memory},
+      {NULL, 0, NULL, 0}};
 
   opterr = 0;
 
-  while ((c = getopt(argc, argv, "otlc:hvDCF")) != -1)
+  while ((c = getopt_long(argc, argv, "otelbkf:hvDCFQMSLpdxc:R:s:j:Pr:w:AB:T:", long_options, NULL)) != -1)
     switch (c)
     {
     case 'l':
       if (mode != undefined)
       {
         fprintf(stderr,
-                "Error: Can only use one of these options [-o -t -l -c]\n");
+                "Error: Can only use one of these options [-o -t -e -l -b]\n");
         exit(1);
       }
       else
         mode = list;
       break;
     case 'o':
-      if (mode != undefined)
+      if (mode == td)
+        mode = fused;
+      else if (mode != undefined)
       {
         fprintf(stderr,
-                "Error: Can only use one of these options [-o -t -l -c]\n");
+                "Error: Can only use one of these options [-o -t -e -l -b]\n");
         exit(1);
       }
       else
         mode = eo;
       break;
     case 't':
-      if (mode != undefined)
+      if (mode == eo)
+        mode = fused;
+      else if (mode != undefined)
       {
         fprintf(stderr,
-                "Error: Can only use one of these options [-o -t -l -c]\n");
+                "Error: Can only use one of these options [-o -t -e -l -b]\n");
         exit(1);
       }
       else
         mode = td;
       break;
+    case 'e':
+      if (mode != undefined)
+      {
+        fprintf(stderr,
+                "Error: Can only use one of these options [-o -t -e -l -b]\n");
+        exit(1);
+      }
+      else
+        mode = evaluate;
+      break;
+    case 'b':
+      if (mode != undefined)
+      {
+        fprintf(stderr,
+                "Error: Can only use one of these options [-o -t -e -l -b]\n");
+        exit(1);
+      }
+      else
+        mode = convert;
+      break;
+    case 'k':
+      cache = 1;
+      break;
+    case 'f':
+      if (strcmp(optarg, "csv") == 0)
+        format = td_format_csv;
+      else if (strcmp(optarg, "td") == 0)
+        format = td_format_pace;
+      else if (strcmp(optarg, "bin") == 0)
+        format = td_format_binary;
+      else
+      {
+        fprintf(stderr, "Error: unknown output format %s\n", optarg);
+        exit(1);
+      }
+      break;
     case 'h':
       fprintf(stdout, "%s\n", usagestring);
       exit(0);
@@ -133,11 +205,121 @@ int main(int argc, char **argv)
     case 'C':
       heuristic = mcs;
       break;
+    case 'Q':
+      heuristic = amd;
+      break;
     case 'v':
       verbose_printing = 1;
       break;
+    case 'M':
+      rep = dense;
+      break;
+    case 'S':
+      rep = sparse;
+      break;
+    case 'P':
+      use_counters = 1;
+      break;
+    case 'c':
+      if (strcmp(optarg, "min") == 0)
+        tie = mcs_tie_min;
+      else if (strcmp(optarg, "max") == 0)
+        tie = mcs_tie_max;
+      else
+      {
+        fprintf(stderr, "Error: unknown tie break %s\n", optarg);
+        exit(1);
+      }
+      break;
+    case 'R':
+      runs = atoi(optarg);
+      if (runs < 1)
+      {
+        fprintf(stderr, "Error: -R needs a positive number of runs\n");
+        exit(1);
+      }
+      break;
+    case 's':
+      seed = strtoull(optarg, NULL, 10);
+      break;
+    case option_time_limit:
+      time_limit = atof(optarg);
+      if (time_limit <= 0)
+      {
+        fprintf(stderr, "Error: --time-limit needs a positive number of seconds\n");
+        exit(1);
+      }
+      break;
+    case option_best_file:
+      best_path = optarg;
+      break;
+    case 'L':
+      stop_at_bound = 1;
+      break;
+    case 'p':
+      reduce = 1;
+      break;
+    case 'd':
+      split = 1;
+      break;
+    case 'x':
+      exact = 1;
+      break;
+    case option_exact_time:
+      exact_time = atof(optarg);
+      if (exact_time <= 0)
+      {
+        fprintf(stderr, "Error: --exact-time needs a positive number of seconds\n");
+        exit(1);
+      }
+      break;
+    case option_exact_memory:
+      exact_memory = atof(optarg);
+      if (exact_memory < 0)
+      {
+        fprintf(stderr, "Error: --exact-memory needs a non-negative number of MB\n");
+        exit(1);
+      }
+      break;
+    case 'j':
+      bench.threads = atoi(optarg);
+      if (bench.threads < 1)
+      {
+        fprintf(stderr, "Error: -j needs a positive number of threads\n");
+        exit(1);
+      }
+      break;
+    case 'r':
+      bench.repeats = atoi(optarg);
+      if (bench.repeats < 1)
+      {
+        fprintf(stderr, "Error: -r needs a positive number of runs\n");
+        exit(1);
+      }
+      break;
+    case 'w':
+      bench.warmups = atoi(optarg);
+      if (bench.warmups < 0)
+      {
+        fprintf(stderr, "Error: -w needs a non-negative number of runs\n");
+        exit(1);
+      }
+      break;
+    case 'A':
+      bench.pin = 1;
+      break;
+    case 'B':
+      baseline_path = optarg;
+      break;
+    case 'T':
+      bench.threshold = atof(optarg);
+      break;
     case '?':
-      if (optopt == 'f')
+      if (optopt == 0)
+        fprintf(stderr, "Unknown option `%s'.\n", argv[optind - 1]);
+      else if (optopt >= option_time_limit)
+        fprintf(stderr, "Option %s requires an argument.\n", argv[optind - 1]);
+      else if (strchr("fcRsjrwBT", optopt))
         fprintf(stderr, "Option -%c requires an argument.\n", optopt);
       else if (isprint(optopt))
         fprintf(stderr, "Unknown option `-%c'.\n", optopt);
@@ -154,12 +336,46 @@ int main(int argc, char **argv)
     }
 
   inputpath = argv[optind];
+  if (mode != undefined && inputpath == NULL)
+  {
+    fprintf(stderr, "Error: no input file given\n%s", usagestring);
+    exit(1);
+  }
+  if (time_limit > 0 && runs > 1)
+  {
+    fprintf(stderr, "Error: --time-limit does its own restarts, it can not be combined with -R\n");
+    exit(1);
+  }
+  if (split && (time_limit > 0 || runs > 1))
+  {
+    fprintf(stderr, "Error: -d can not be combined with -R or --time-limit\n");
+    exit(1);
+  }
+  if (exact && (split || time_limit > 0 || runs > 1))
+  {
+    fprintf(stderr, "Error: -x can not be combined with -d, -R or --time-limit\n");
+    exit(1);
+  }
+  if (best_path && time_limit <= 0)
+  {
+    fprintf(stderr, "Error: --best-file needs --time-limit\n");
+    exit(1);
+  }
+
+  if (use_counters)
+  {
+    struct perf_counters perf;
+    if (perf_counters_open(&perf) < PERF_COUNTERS)
+      fprintf(stderr, "Warning: not all hardware counters are available, "
+                      "check /proc/sys/kernel/perf_event_paranoid\n");
+    perf_counters_close(&perf);
+  }
 
   /* --------- Benchmark mode ------------- */
   if (mode == list)
   {
     /* Open input file list and create result file */
-    FILE *results = fopen("results.csv", "a");
+    FILE *results = fopen("results.csv", "a+");
     if (results == NULL)
     {
       perror("Error opening results file");
@@ -172,6 +388,17 @@ int main(int argc, char **argv)
     {
       print_file_header(results);
     }
+    else
+    {
+      /* appending rows with different columns would break the file */
+      rewind(results);
+      if (!file_header_matches(results))
+      {
+        fprintf(stderr, "Error: results.csv has different columns, move it away first\n");
+        fclose(results);
+        exit(1);
+      }
+    }
     FILE *inputfiles = fopen(inputpath, "r");
     if (inputfiles == NULL)
     {
@@ -179,101 +406,283 @@ int main(int argc, char **argv)
       fclose(results);
       exit(1);
     }
-
-    /* Iterate through the entries in input file list and do benchmark for each file */
-    char filename[FILENAME_MAX_LENGTH];
-    FILE *current;
-    int failed = 0;
-    while (fgets(filename, FILENAME_MAX_LENGTH, inputfiles) != NULL)
+    bench.rep = rep;
+    bench.use_counters = use_counters;
+    bench.cache = cache;
+    bench.mcs_tie = tie;
+    bench.reduce = reduce;
+    if (baseline_path)
     {
-      /* trim leading newline*/
-      filename[strcspn(filename, "\n")] = 0;
-      current = fopen(filename, "r");
-      if (current == NULL)
+      FILE *baseline = fopen(baseline_path, "r");
+      if (baseline == NULL)
       {
-        fprintf(stderr, "Error opening file %s: ", filename);
-        perror("");
-        errno = 0;
-        failed++;
-        continue;
+        perror("Error opening baseline file");
+        exit(1);
       }
-      char benchmark_fail = benchmark(filename, current, results);
-      if (benchmark_fail)
+      bench.baseline = benchmark_baseline_load(baseline);
+      fclose(baseline);
+      if (bench.baseline == NULL)
       {
-        fprintf(stderr, "Error processing input file %s\n", filename);
-        failed++;
+        fprintf(stderr, "Error reading baseline file %s\n", baseline_path);
+        exit(1);
       }
-      fclose(current);
     }
-    /* Check if we reached end or there was an error */
-    if (errno)
-      perror("Error reading input file list: ");
+
+    int regressions;
+    int failed = benchmark_run(inputfiles, results, &bench, &regressions);
+    if (failed < 0)
+      perror("Error reading input file list");
     else
-    {
       printf("Benchmark completed, there were %d failures\n", failed);
-    }
+    benchmark_baseline_free(bench.baseline);
     fclose(inputfiles);
     fclose(results);
+    if (regressions > 0)
+    {
+      fprintf(stderr, "%d heuristic timings regressed by more than %g%% and %g ms\n", regressions, bench.threshold,
+              BENCHMARK_REGRESSION_FLOOR * 1000);
+      exit(2);
+    }
     exit(0);
   }
   /* ----------- Analyze single graph -------------- */
-  else if (mode == eo || mode == td)
+  else if (mode == eo || mode == td || mode == fused || mode == evaluate)
   {
-    FILE *inputfile = fopen(inputpath, "r");
-    if (inputfile == NULL)
-    {
-      perror("Error opening input file");
-      exit(1);
-    }
-    Graph g = graph_import(inputfile);
+    double import_start = timing_now();
+    Graph g = graph_import_path(inputpath, rep, cache);
+    double import_time = timing_now() - import_start;
     if (g == NULL)
     {
       fprintf(stderr, "Error importing graph\n");
-      fclose(inputfile);
       exit(1);
     }
-    fclose(inputfile);
 
-    /* ------- Elimination Ordering only ----------- */
-    if (mode == eo)
+    /* ------- Elimination Ordering (and decomposition) ----------- */
+    if (mode == eo || mode == fused)
     {
-      float start, end, time_f;
-      if(verbose_printing) start = clock();
+      /* keep stdout for the decomposition in fused mode
+          and for the improving orderings of --time-limit */
+      FILE *info = mode == fused || time_limit > 0 ? stderr : stdout;
+      struct perf_counters perf;
+      long long counts[PERF_COUNTERS];
+      if (use_counters)
+      {
+        perf_counters_open(&perf);
+        perf_counters_start(&perf);
+      }
+      /* the bound needs the graph before it is ordered */
+      int lower_bound = -1;
+      double time_lb = 0;
+      if (stop_at_bound || verbose_printing)
+      {
+        double lb_start = timing_now();
+        lower_bound = graph_lower_bound(g, lb_best);
+        time_lb = timing_now() - lb_start;
+      }
+      /* with -p the heuristics order the kernel of the reductions */
+      struct reduction reduction;
+      double time_reduce = 0;
+      Graph target = g;
+      if (reduce)
+      {
+        double reduce_start = timing_now();
+        int low = lower_bound >= 0 ? lower_bound : graph_lower_bound(g, lb_min_d);
+        if (!reduction_run(g, low, &reduction))
+        {
+          fprintf(stderr, "Error reducing the graph\n");
+          graph_destroy(g);
+          exit(1);
+        }
+        time_reduce = timing_now() - reduce_start;
+        target = reduction.kernel;
+        if (lower_bound >= 0 && reduction.low > lower_bound)
+          lower_bound = reduction.low;
+      }
+      double start = timing_now();
 
+      graph_set_threads(target, bench.threads);
+      /* the graph holding the ordering, the best clone with -R */
+      Graph ordered = target;
+      struct multistart_result multi = {NULL, -1, -1, 0, NULL};
+      struct anytime_result anytime;
+      struct decomposition decomposition;
+      struct exact_result exact_search;
       int width;
-      switch (heuristic)
-      {
-      case degree:
-        width = graph_order_degree(g);
-        break;
-      case fillin:
-        width = graph_order_fillin(g);
-        break;
-      case mcs:
-        width = graph_order_mcs(g);
-        break;
-
-      default:
-        abort();
-        break;
+      if (time_limit > 0)
+      {
+        if (!anytime_order(target, time_limit, seed, stop_at_bound ? lower_bound : -1,
+                           reduce ? &reduction : NULL, mode == eo ? stdout : NULL, best_path, stderr, &anytime))
+        {
+          fprintf(stderr, "Error: no ordering was found\n");
+          graph_destroy(g);
+          exit(1);
+        }
+        width = anytime.best_width;
+      }
+      else if (runs > 1)
+      {
+        if (!multistart_order(target, heuristic, tie, runs, bench.threads, seed,
+                              stop_at_bound ? lower_bound : -1, &multi))
+        {
+          fprintf(stderr, "Error: no run created an ordering\n");
+          multistart_result_free(&multi);
+          graph_destroy(g);
+          exit(1);
+        }
+        ordered = multi.best;
+        width = multi.best_width;
+      }
+      else if (split)
+      {
+        if (!decompose_order(target, heuristic, tie, bench.threads, &decomposition))
+        {
+          fprintf(stderr, "Error: a part of the graph could not be ordered\n");
+          graph_destroy(g);
+          exit(1);
+        }
+        width = decomposition.width;
+      }
+      else if (exact)
+      {
+        if (!exact_order(target, heuristic, tie, reduce ? reduction.low : -1, exact_time,
+                         (size_t)(exact_memory * 1024 * 1024), bench.threads, &exact_search))
+        {
+          fprintf(stderr, "Error: the exact search needs at most %d vertices and enough memory\n",
+                  EXACT_MAX_VERTICES);
+          graph_destroy(g);
+          exit(1);
+        }
+        width = exact_search.width;
+      }
+      else
+        width = graph_order(target, heuristic, tie);
+      struct ordering_times phases = graph_ordering_times(ordered);
+      if (reduce)
+      {
+        /* the ordering of the whole graph: the prefix, then the kernel */
+        int *kernel_ordering = (int *)malloc(sizeof(int) * (reduction.kernel_n + 1));
+        int *ordering = (int *)malloc(sizeof(int) * (reduction.n + 1));
+        if (!kernel_ordering || !ordering)
+        {
+          fprintf(stderr, "Out of memory\n");
+          exit(1);
+        }
+        graph_get_ordering(ordered, kernel_ordering);
+        reduction_expand(&reduction, kernel_ordering, ordering);
+        graph_set_ordering(g, ordering);
+        free(kernel_ordering);
+        free(ordering);
+        ordered = g;
+        if (reduction.width > width)
+          width = reduction.width;
+      }
+      double time_f = timing_now() - start;
+      if (use_counters)
+      {
+        perf_counters_stop(&perf, counts);
+        perf_counters_close(&perf);
       }
       if (verbose_printing)
       {
-        end = clock();
-        time_f = (end - start) / CLOCKS_PER_SEC;
-        printf("File: %s\n", inputpath);
-        printf("Heuristic: %s\n", STRATEGY[heuristic]);
-        printf("Ordering: ");
+        fprintf(info, "File: %s\n", inputpath);
+        if (time_limit > 0)
+          fprintf(info, "Heuristic: Anytime (%s, %s, restarts and local search)\n", STRATEGY[degree], STRATEGY[fillin]);
+        else
+          fprintf(info, "Heuristic: %s\n", STRATEGY[heuristic]);
+        if (heuristic == mcs && time_limit <= 0)
+          fprintf(info, "Tie break: %s degree\n", tie == mcs_tie_min ? "min" : "max");
+        fprintf(info, "Representation: %s\n", graph_representation(g) == sparse ? "sparse" : "bit matrix");
+        fprintf(info, "Bitset kernels: %s\n", bitset_kernel_name());
+        fprintf(info, "Ordering: ");
+      }
+      /* --time-limit printed its orderings already */
+      if ((mode == eo && time_limit <= 0) || verbose_printing)
+      {
+        graph_print_ordering(ordered, info);
+        fprintf(info, "\n");
       }
-      graph_print_ordering(g, stdout);
-      printf("\n");
       if (verbose_printing)
       {
-        printf("Width: %d\n", width);
-        printf("Execution time of ordering: %f\n", time_f);
+        fprintf(info, "Width: %d\n", width);
+        if (lower_bound >= 0)
+          fprintf(info, "Lower bound: %d%s\n", lower_bound, width == lower_bound ? " (the width is optimal)" : "");
+        if (reduce)
+        {
+          fprintf(info, "Reduction: %d of %d vertices eliminated (width %d), kernel of %d vertices\n",
+                  reduction.prefix_len, reduction.n, reduction.width, reduction.kernel_n);
+          fprintf(info, "Reduction rules: ");
+          reduction_print_rules(&reduction, info);
+        }
+        if (split)
+          fprintf(info, "Decomposition: %d parts (%d components, %d clique separators%s), largest part %d vertices\n",
+                  decomposition.parts, decomposition.components, decomposition.separators,
+                  decomposition.atoms ? "" : " not searched, graph too large", decomposition.largest);
+        if (exact)
+        {
+          fprintf(info, "Exact search: %s, heuristic width %d, lower bound %d\n",
+                  exact_search.optimal ? "completed (the width is optimal)" : "stopped at the time limit",
+                  exact_search.heuristic_width, exact_search.lower_bound);
+          fprintf(info, "Search nodes: %lld, skipped by the memo table: %lld\n",
+                  exact_search.nodes, exact_search.memo_hits);
+          fprintf(info, "Memo table: %lld sets stored, %lld evicted\n",
+                  exact_search.memo_entries, exact_search.memo_evictions);
+        }
+        if (runs > 1)
+        {
+          fprintf(info, "Runs: %d (seed %llu), best run: %d\n", runs, (unsigned long long)seed, multi.best_run);
+          fprintf(info, "Widths of the runs: ");
+          multistart_print_widths(&multi, info);
+        }
+        if (time_limit > 0)
+        {
+          fprintf(info, "Time limit: %g s, best ordering after %f s (%s)\n", time_limit, anytime.best_time, anytime.phase);
+          fprintf(info, "Improvements: %d, restarts: %d, local search moves: %ld\n",
+                  anytime.improvements, anytime.restarts, anytime.moves);
+        }
+        fprintf(info, "Execution time of import: %f\n", import_time);
+        struct stat stats;
+        if (stat(inputpath, &stats) == 0 && S_ISREG(stats.st_mode) && import_time > 0)
+          fprintf(info, "Import throughput: %.1f MB/s\n", stats.st_size / import_time / 1e6);
+        /* -d and -x order copies */
+        if (time_limit <= 0 && !split && !exact)
+        {
+          fprintf(info, "Execution time of initial priorities: %f\n", phases.initial);
+          fprintf(info, "Execution time of eliminations: %f\n", phases.ordering);
+          fprintf(info, "Execution time of width evaluation: %f\n", phases.width);
+        }
+        fprintf(info, "Execution time of ordering: %f\n", time_f);
+        if (lower_bound >= 0)
+          fprintf(info, "Execution time of lower bound: %f\n", time_lb);
+        if (reduce)
+          fprintf(info, "Execution time of reduction: %f\n", time_reduce);
+        if (split)
+          fprintf(info, "Execution time of splitting: %f\n", decomposition.time_split);
+        if (exact)
+          fprintf(info, "Execution time of exact search: %f\n", exact_search.time);
+        for (int c = 0; use_counters && c < PERF_COUNTERS; c++)
+        {
+          if (counts[c] >= 0)
+            fprintf(info, "%s: %lld\n", PERF_COUNTER_NAMES[c], counts[c]);
+        }
+      }
+      if (mode == fused)
+      {
+        double td_start = timing_now();
+        if (!graph_write_treedecomp(ordered, stdout, format))
+        {
+          fprintf(stderr, "Error writing tree decomposition\n");
+          multistart_result_free(&multi);
+          graph_destroy(g);
+          exit(1);
+        }
+        if (verbose_printing)
+          fprintf(info, "Execution time of decomposition: %f\n", timing_now() - td_start);
       }
+      multistart_result_free(&multi);
+      if (reduce)
+        reduction_free(&reduction);
     }
-    /* ------- Tree decomposition conversion ------- */
+    /* ------- Tree decomposition conversion or evaluation ------- */
     else
     {
       if (optind + 1 >= argc)
@@ -291,13 +700,42 @@ int main(int argc, char **argv)
         exit(1);
       }
       if(!graph_import_ordering(g, eo_file)) {
-        fprintf(stderr, "Error importing elimination ordering");
+        fprintf(stderr, "Error importing elimination ordering\n");
         graph_destroy(g);
         fclose(eo_file);
         exit(1);
       };
       fclose(eo_file);
+      if (!graph_ordering_plausible(g))
+      {
+        fprintf(stderr, "Error: the elimination ordering has to contain every vertex exactly once\n");
+        graph_destroy(g);
+        exit(1);
+      }
 
+      if (mode == evaluate)
+      {
+        double start = timing_now();
+        int width = graph_ordering_width(g);
+        double time_w = timing_now() - start;
+        if (width < 0)
+        {
+          fprintf(stderr, "Error evaluating elimination ordering\n");
+          graph_destroy(g);
+          exit(1);
+        }
+        if (verbose_printing)
+        {
+          printf("Graph file: %s\n", inputpath);
+          printf("Elimination ordering file: %s\n", eo_filepath);
+          printf("Width: %d\n", width);
+          printf("Execution time of width evaluation: %f\n", time_w);
+        }
+        else
+          printf("%d\n", width);
+        graph_destroy(g);
+        exit(0);
+      }
       if (verbose_printing)
       {
         printf("Graph file: %s\n", inputpath);
@@ -305,9 +743,55 @@ int main(int argc, char **argv)
         printf("Ordering: ");
         graph_print_ordering(g, stdout);
         printf("\n");
+        printf("Width: %d\n", graph_ordering_width(g));
       }
-      graph_eo_to_treedecomp(g);
+      if (!graph_eo_to_treedecomp(g, stdout, format))
+      {
+        fprintf(stderr, "Error writing tree decomposition\n");
+        graph_destroy(g);
+        exit(1);
+      }
+    }
+    graph_destroy(g);
+  }
+  /* ----------- Convert to binary format -------------- */
+  else if (mode == convert)
+  {
+    Graph g = graph_import_path(inputpath, rep, 0);
+    if (g == NULL)
+    {
+      fprintf(stderr, "Error importing graph\n");
+      exit(1);
+    }
+    char *outputpath = optind + 1 < argc ? argv[optind + 1] : NULL;
+    char *defaultpath = NULL;
+    if (outputpath == NULL)
+    {
+      defaultpath = malloc(strlen(inputpath) + sizeof(TDBIN_EXTENSION));
+      if (defaultpath == NULL)
+      {
+        perror("Error converting graph");
+        exit(1);
+      }
+      sprintf(defaultpath, "%s%s", inputpath, TDBIN_EXTENSION);
+      outputpath = defaultpath;
+    }
+    FILE *outputfile = fopen(outputpath, "wb");
+    if (outputfile == NULL)
+    {
+      perror("Error opening output file");
+      exit(1);
+    }
+    char written = graph_export_binary(g, outputfile);
+    if (fclose(outputfile) != 0 || !written)
+    {
+      fprintf(stderr, "Error writing %s\n", outputpath);
+      exit(1);
     }
+    if (verbose_printing)
+      printf("Wrote %s: %d vertices, %d edges\n", outputpath,
+             graph_vertex_count(g), graph_edge_count(g));
+    free(defaultpath);
     graph_destroy(g);
   }
   exit(0);